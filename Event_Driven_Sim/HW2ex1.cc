@@ -1,18 +1,174 @@
 #include <errno.h>
+#include <string.h>
 #include <signal.h>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
 #include <queue>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "hcm.h"
 #include "flat.h"
+#include "cleanup.h"
 #include "hcmvcd.h"
 #include "hcmsigvec.h"
+#include "hcmstim.h"
+#include "gatekernels.h"
 
 using namespace std;
 
 const bool INIT_VAL = false;
-typedef list<hcmInstance*> FanOutGates;
+
+/**
+ * @brief Evaluates a gate on the packed net values. pins holds the input nets, the CLK pin
+ * first, followed by the output nets. bit n of val and newVal is the value of net n.
+ */
+typedef bool (*GateEvalFn)(const int* pins, int numInputs, const uint64_t* val, const uint64_t* newVal);
+
+template<GateOp Op, int N>
+bool evalGate(const int* pins, int, const uint64_t*, const uint64_t* newVal) {
+    uint64_t in[N];
+    for (int i = 0; i < N; i++) {
+        in[i] = newVal[pins[i] / 64] >> (pins[i] % 64);
+    }
+    return gateKernel<Op, N>(in) & 1;
+}
+
+inline bool evalDff(const int* pins, int numInputs, const uint64_t* val, const uint64_t* newVal) {
+    return dffKernel(newVal[pins[0] / 64] >> (pins[0] % 64), val[pins[1] / 64] >> (pins[1] % 64),
+                     newVal[pins[numInputs] / 64] >> (pins[numInputs] % 64)) & 1;
+}
+
+/**
+ * @brief Evaluates a gate wider than the specialized kernels with a runtime loop.
+ */
+template<GateOp Op>
+bool evalWideGate(const int* pins, int numInputs, const uint64_t*, const uint64_t* newVal) {
+    uint64_t acc = (Op == AND || Op == NAND) ? ~0ULL : 0;
+    for (int i = 0; i < numInputs; i++) {
+        uint64_t v = newVal[pins[i] / 64] >> (pins[i] % 64);
+        acc = (Op == AND || Op == NAND) ? (acc & v) : (Op == XOR) ? (acc ^ v) : (acc | v);
+    }
+    return (acc & 1) ^ (Op == NAND || Op == NOR);
+}
+
+inline bool evalUnsupported(const int*, int, const uint64_t*, const uint64_t*) {
+    cerr << "ERROR: Gate in not supported by the simulator" << endl;
+    exit(0);
+    return true;
+}
+
+/**
+ * @brief The evaluators of all the gate functions by kernel column, see getKernelColumn.
+ */
+struct GateKernelTable {
+    GateEvalFn eval[UNSUPPORTED][MAX_KERNEL_INPUTS + 2];
+
+    GateKernelTable();
+};
+
+/**
+ * @brief Fills columns 1 to N of the row of Op with its kernels.
+ */
+template<GateOp Op, int N>
+struct GateEvalRow {
+    static void fill(GateKernelTable& t) {
+        t.eval[Op][N] = &evalGate<Op, N>;
+        GateEvalRow<Op, N - 1>::fill(t);
+    }
+};
+
+template<GateOp Op>
+struct GateEvalRow<Op, 0> {
+    static void fill(GateKernelTable&) {}
+};
+
+template<GateOp Op>
+void fillWideRow(GateKernelTable& t) {
+    GateEvalRow<Op, MAX_KERNEL_INPUTS>::fill(t);
+    t.eval[Op][MAX_KERNEL_INPUTS + 1] = &evalWideGate<Op>;
+}
+
+inline GateKernelTable::GateKernelTable() {
+    for (int op = 0; op < UNSUPPORTED; op++) {
+        for (int n = 0; n < MAX_KERNEL_INPUTS + 2; n++) {
+            eval[op][n] = &evalUnsupported;
+        }
+    }
+    GateEvalRow<BUFFER, 1>::fill(*this);
+    GateEvalRow<NOT, 1>::fill(*this);
+    fillWideRow<OR>(*this);
+    fillWideRow<NOR>(*this);
+    fillWideRow<AND>(*this);
+    fillWideRow<NAND>(*this);
+    fillWideRow<XOR>(*this);
+    eval[DFF][2] = &evalDff;
+}
+
+inline const GateKernelTable& getGateKernelTable() {
+    static GateKernelTable table;
+    return table;
+}
+
+/**
+ * @brief Gets the evaluator of a gate by its function and number of inputs.
+ */
+inline GateEvalFn getGateEvalFn(GateOp op, int numInputs) {
+    if (op >= UNSUPPORTED) {
+        return &evalUnsupported;
+    }
+    return getGateKernelTable().eval[op][getKernelColumn(op, numInputs)];
+}
+
+/**
+ * @brief Fills the table with the pattern parallel kernels of the given width, using the SIMD
+ * kernels when the CPU supports them and the portable ones otherwise.
+ *
+ * @param width The number of patterns per block, 64, 256 or 512, 0 for the widest the CPU supports.
+ * @return 0 on success, 1 if the width is not supported
+ */
+int getGateBlockTable(int width, GateBlockTable& t) {
+    bool hasAvx2 = false;
+    bool hasAvx512 = false;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    hasAvx2 = __builtin_cpu_supports("avx2");
+    hasAvx512 = __builtin_cpu_supports("avx512f");
+#endif
+    if (width == 0) {
+        width = hasAvx512 ? 512 : hasAvx2 ? 256 : 64;
+    }
+
+    switch (width) {
+        case 64:
+            GateBlockKernels<uint64_t>::fill(t, "scalar");
+            return 0;
+        case 256:
+            if (hasAvx2) {
+                getAvx2BlockTable(t);
+            }
+            else {
+                GateBlockKernels<GateWords<4> >::fill(t, "portable");
+            }
+            return 0;
+        case 512:
+            if (hasAvx512) {
+                getAvx512BlockTable(t);
+            }
+            else {
+                GateBlockKernels<GateWords<8> >::fill(t, "portable");
+            }
+            return 0;
+        default:
+            return 1;
+    }
+}
 
 /**
  * @brief Represents an event in the simulation.
@@ -26,9 +182,13 @@ class Event {
     hcmNode*    node;
     EVENT_TYPE  type;
     bool        value;
+    // the net ID of the node in the net table
+    int         net;
 
 public:
-    Event(hcmNode* node, EVENT_TYPE type, bool value) : node(node), type(type), value(value) {}
+    Event() : node(NULL), type(UPDATE_EVENT), value(false), net(-1) {}
+
+    Event(hcmNode* node, EVENT_TYPE type, bool value, int net) : node(node), type(type), value(value), net(net) {}
 
     ~Event() {}
 
@@ -37,51 +197,181 @@ public:
 };
 
 /**
- * @brief Manages a queue of events.
+ * @brief Schedules the events on a timing wheel.
+ *
+ * Every bucket of the wheel holds the events of one time step in insertion order, events
+ * further than the wheel size away wait in a time ordered overflow list. Every net keeps the
+ * pool index of its latest pending event so coalescing and cancelling are O(1). A cancelled
+ * event stays in its bucket or in the overflow list as a dead entry until the step is drained.
+ * The unit delay model schedules everything one step after the bucket being processed.
  */
 class EventQueue {
-    list<Event> events;
+    // the event pool, the time of every event, whether it is still pending and the free entries
+    vector<Event>    pool;
+    vector<uint64_t> eventTime;
+    vector<bool>     live;
+    vector<int>      freeEvents;
+
+    // EVENT_WHEEL_SIZE buckets of pool indexes, bucket t % EVENT_WHEEL_SIZE holds time t
+    vector<vector<int>>        wheel;
+    multimap<uint64_t, int>    farEvents;
+    // per net ID - the pool index of its latest pending event, -1 if none
+    vector<int>      pendingSlot;
+    // the time of the bucket processed last, the number of pending events and how many of them
+    // wait in the overflow list
+    uint64_t         now;
+    size_t           numPending;
+    size_t           numFar;
+
+    static const uint64_t EVENT_WHEEL_SIZE = 64;
+
+    vector<int>& bucket(uint64_t t) {
+        return wheel[t % EVENT_WHEEL_SIZE];
+    }
+
+    void release(int idx) {
+        live[idx] = false;
+        freeEvents.push_back(idx);
+        numPending--;
+    }
 
 public:
-    EventQueue() {}
+    EventQueue() : wheel(EVENT_WHEEL_SIZE), now(0), numPending(0), numFar(0) {}
 
     ~EventQueue() {}
 
     bool empty() {
-        return events.empty();
+        return numPending == 0;
     }
 
-    list<Event>::iterator find(Event event) {
-        std::list<Event>::iterator event_it;
+    uint64_t getTime() {
+        return now;
+    }
 
-        for (event_it = events.begin(); event_it != events.end(); event_it++) {
-            if (event_it->node == event.node) {
-                return event_it;
-            }
+    /**
+     * @brief Schedules the event \a delay steps after the current time. An event pending for
+     * the same net at the same time only gets the new value.
+     *
+     * @return 0 on success, 1 if the delay is 0 since the events of the current step were taken
+     */
+    int insert(Event event, uint64_t delay = 1) {
+        if (delay == 0) {
+            cerr << "-E- An event can not be scheduled at the current time step " << now << endl;
+            return 1;
+        }
+        uint64_t t = now + delay;
+        if ((size_t)event.net >= pendingSlot.size()) {
+            pendingSlot.resize(event.net + 1, -1);
         }
 
-        return events.end();
-    }
+        int slot = pendingSlot[event.net];
+        if (slot >= 0 && eventTime[slot] == t) {
+            pool[slot].value = event.value;
+            return 0;
+        }
 
-    void insert(Event event) {
-        std::list<Event>::iterator event_it = find(event);
+        int idx;
+        if (!freeEvents.empty()) {
+            idx = freeEvents.back();
+            freeEvents.pop_back();
+            pool[idx] = event;
+            eventTime[idx] = t;
+            live[idx] = true;
+        }
+        else {
+            idx = pool.size();
+            pool.push_back(event);
+            eventTime.push_back(t);
+            live.push_back(true);
+        }
+        pendingSlot[event.net] = idx;
+        numPending++;
 
-        if (event_it != events.end()) {
-            event_it->value = event.value;
+        if (delay < EVENT_WHEEL_SIZE) {
+            bucket(t).push_back(idx);
         }
         else {
-            events.push_back(event);
+            farEvents.insert(make_pair(t, idx));
+            numFar++;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Cancels the latest pending event of the net, if any. Its pool entry is reused only
+     * once the bucket or the overflow list holding it is drained.
+     */
+    void cancel(int net) {
+        if ((size_t)net >= pendingSlot.size() || pendingSlot[net] < 0) {
+            return;
+        }
+        int idx = pendingSlot[net];
+        pendingSlot[net] = -1;
+        live[idx] = false;
+        numPending--;
+        if (eventTime[idx] >= now + EVENT_WHEEL_SIZE) {
+            numFar--;
         }
     }
 
-    void remove(Event event) {
-        list<Event>::iterator event_it = find(event);
-        events.erase(event_it);
+    /**
+     * @brief Advances the time to the next step with pending events and moves them out of the queue.
+     *
+     * @param events Filled with the events of that step in the order they were scheduled.
+     */
+    void popNext(vector<Event>& events) {
+        events.clear();
+        while (numPending) {
+            if (numPending == numFar) {
+                // the wheel is empty, jump right before the first overflow event
+                now = farEvents.begin()->first - 1;
+            }
+            now++;
+            // bring the overflow events that are now within the wheel, freeing the cancelled ones
+            while (!farEvents.empty() && farEvents.begin()->first < now + EVENT_WHEEL_SIZE) {
+                int idx = farEvents.begin()->second;
+                if (live[idx]) {
+                    bucket(farEvents.begin()->first).push_back(idx);
+                    numFar--;
+                }
+                else {
+                    freeEvents.push_back(idx);
+                }
+                farEvents.erase(farEvents.begin());
+            }
+
+            vector<int>& b = bucket(now);
+            for (size_t i = 0; i < b.size(); i++) {
+                int idx = b[i];
+                if (!live[idx]) {
+                    freeEvents.push_back(idx);
+                    continue;
+                }
+                events.push_back(pool[idx]);
+                if (pendingSlot[pool[idx].net] == idx) {
+                    pendingSlot[pool[idx].net] = -1;
+                }
+                release(idx);
+            }
+            b.clear();
+            if (!events.empty()) {
+                return;
+            }
+        }
     }
 
     void printEventQueue() {
-        for (auto it : events) {
-            cout << "EVENT: " << " node: " << it.node->getName() << " value: " << it.value << endl;
+        for (uint64_t t = now + 1; t < now + EVENT_WHEEL_SIZE; t++) {
+            for (auto idx : bucket(t)) {
+                if (live[idx]) {
+                    cout << "EVENT: " << " time: " << t << " node: " << pool[idx].node->getName() << " value: " << pool[idx].value << endl;
+                }
+            }
+        }
+        for (auto it : farEvents) {
+            if (live[it.second]) {
+                cout << "EVENT: " << " time: " << it.first << " node: " << pool[it.second].node->getName() << " value: " << pool[it.second].value << endl;
+            }
         }
         cout << endl;
     }
@@ -93,13 +383,30 @@ public:
  * @brief Manages a queue of gates (logic gates in the circuit).
  */
 class GateQueue {
-    list<hcmInstance*> gates;
+    // the IDs of the scheduled gates in scheduling order
+    vector<int>          gates;
+    // gate ID to gate, only used while building the ID table
+    vector<hcmInstance*> gateById;
+    map<hcmInstance*, int> idByGate;
+    // a gate is scheduled if its stamp equals the current epoch, draining moves to a new epoch
+    vector<unsigned>     stamp;
+    unsigned             epoch;
 
 public:
-    typedef enum {
-        BUFFER, NOT, DFF,
-        OR, NOR, AND, NAND, XOR
-    } GATES;
+    typedef GateOp GATES;
+
+    /**
+     * @brief A gate compiled for evaluation. Its pins are pins[firstPin] onwards, first the input
+     * nets with the CLK pin first, then the output nets.
+     */
+    struct GateRecord {
+        GATES   op;
+        // the kernel of the gate function and number of inputs
+        GateEvalFn eval;
+        int     numInputs;
+        int     numOutputs;
+        int     firstPin;
+    };
 
     map<string, GATES> gates_map =
     {
@@ -115,7 +422,7 @@ public:
         {"or9",OR}, {"nor9",NOR}, {"and9",AND}, {"nand9",NAND}
     };
 
-    GateQueue() {}
+    GateQueue() : epoch(1) {}
 
     ~GateQueue() {}
 
@@ -123,192 +430,244 @@ public:
         return gates.empty();
     }
 
-    void remove(hcmInstance* gate) {
-        auto gate_it = std::find(gates.begin(), gates.end(), gate);
-        gates.erase(gate_it);
+    /**
+     * @brief Gets the gate ID of the instance, assigning one on first use. Call it while building the tables.
+     */
+    int getGateId(hcmInstance* gate) {
+        auto gI = idByGate.find(gate);
+        if (gI != idByGate.end()) {
+            return gI->second;
+        }
+        int id = gateById.size();
+        idByGate[gate] = id;
+        gateById.push_back(gate);
+        stamp.push_back(0);
+        return id;
     }
 
-    bool simulate(hcmInstance* gate, vector<bool> oldGateInputs, vector<bool> gateInputs, bool gate_output) {
-        bool output = false;
-
-        switch (gateToEnum(gate->masterCell()->getName())) {
-            case BUFFER:
-                return gateInputs[0];
-                break;
-
-            case NOT:
-                return !gateInputs[0];
-                break;
-
-            case DFF:
-                return gateInputs[0] ? oldGateInputs[1] : gate_output;
-                break;
+    hcmInstance* getGate(int id) {
+        return gateById[id];
+    }
 
-            case XOR:
-                return gateInputs[0] ^ gateInputs[1];
-                break;
+    /**
+     * @brief Schedules the gate unless already scheduled.
+     */
+    void schedule(int id) {
+        if (stamp[id] != epoch) {
+            stamp[id] = epoch;
+            gates.push_back(id);
+        }
+    }
 
-            case OR:
-                output = false;
-                for (size_t i = 0; i < gateInputs.size(); i++) {
-                    output = output || gateInputs[i];
-                }
-                return output;
-                break;
+    /**
+     * @brief Moves all the scheduled gates out of the queue, they may be scheduled again right after.
+     *
+     * @param out Filled with the gate IDs in scheduling order.
+     */
+    void drain(vector<int>& out) {
+        out.swap(gates);
+        gates.clear();
+        if (++epoch == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            epoch = 1;
+        }
+    }
 
-            case NOR:
-                output = false;
-                for (size_t i = 0; i < gateInputs.size(); i++) {
-                    output = output || gateInputs[i];
-                }
-                return !output;
-                break;
+    /**
+     * @brief Compiles the gate into its record, once before simulating.
+     *
+     * @param id The gate ID.
+     * @param inputs The input net IDs, the CLK pin first.
+     * @param outputs The output net IDs.
+     */
+    void compile(int id, const vector<int>& inputs, const vector<int>& outputs) {
+        if ((size_t)id >= records.size()) {
+            records.resize(id + 1);
+        }
+        GateRecord& g = records[id];
+        g.op = gateToEnum(gateById[id]->masterCell()->getName());
+        g.numInputs = inputs.size();
+        g.numOutputs = outputs.size();
+        g.eval = getGateEvalFn(g.op, g.numInputs);
+        g.firstPin = pins.size();
+        pins.insert(pins.end(), inputs.begin(), inputs.end());
+        pins.insert(pins.end(), outputs.begin(), outputs.end());
+    }
 
-            case AND:
-                output = true;
-                for (size_t i = 0; i < gateInputs.size(); i++) {
-                    output = output && gateInputs[i];
-                }
-                return output;
-                break;
+    const GateRecord& getRecord(int id) {
+        return records[id];
+    }
 
-            case NAND:
-                output = true;
-                for (size_t i = 0; i < gateInputs.size(); i++) {
-                    output = output && gateInputs[i];
-                }
-                return !output;
-                break;
+    const int* getPins(const GateRecord& g) {
+        return pins.data() + g.firstPin;
+    }
 
-            default:
-                cerr << "ERROR: Gate in not supported by the simulator" << endl;
-                exit(0);
-                break;
-        }
-        return true;
+    /**
+     * @brief Evaluates a compiled gate on the packed net values.
+     *
+     * @param g The gate record.
+     * @param val The current values of the nets, bit n of the words is the value of net n.
+     * @param newVal The new values of the nets.
+     * @return the new value of the gate outputs
+     */
+    bool simulate(const GateRecord& g, const uint64_t* val, const uint64_t* newVal) {
+        return g.eval(pins.data() + g.firstPin, g.numInputs, val, newVal);
     }
 
     GATES gateToEnum(string gateName) {
-        return gates_map.find(gateName)->second;
+        map<string, GATES>::const_iterator gI = gates_map.find(gateName);
+        if (gI == gates_map.end()) {
+            return UNSUPPORTED;
+        }
+        return gI->second;
     }
 
     void printGateQueue() {
-        for (auto it : gates) {
-            cout << "GATE: " << " cell: " << it->masterCell()->getName() << " inst: " << it->getName() << endl;
+        for (auto id : gates) {
+            cout << "GATE: " << " cell: " << gateById[id]->masterCell()->getName() << " inst: " << gateById[id]->getName() << endl;
         }
         cout << endl;
     }
 
+private:
+    // the compiled gates by gate ID and the net IDs of their pins
+    vector<GateRecord>   records;
+    vector<int>          pins;
+
     friend class EventDrivenSim;
 };
 
 /**
- * @brief Represents an entry in the net table, storing the current and new values of a node in the circuit.
+ * @brief Holds the state of all the nets in structure of arrays form indexed by net ID.
+ *
+ * The current value, the new value and the initial value flag of the nets are packed bitsets.
+ * The fanout gates of all the nets are kept in CSR form, the gate IDs of net n are
+ * fanoutGates[fanoutBegin[n]] to fanoutGates[fanoutBegin[n + 1] - 1].
  */
-class NetTableEntry {
-    bool        val;
-    bool        newVal;
-    bool        init_val;
-    hcmNode*    node;
-    FanOutGates fanOut_gates;
-
-public:
-    NetTableEntry(bool val, bool newVal, hcmNode* node, FanOutGates fanOut_gates, bool init_val = true) :
-        val(val), newVal(newVal), init_val(init_val), node(node), fanOut_gates(fanOut_gates) {};
-
-    ~NetTableEntry() {};
-
-    void update(bool newVal) {
-        init_val = false;
-        this->newVal = newVal;
-    }
+class NetTable {
+    vector<hcmNode*>        nodes;
+    map<const hcmNode*, int> idByNode;
 
-    void advanceTime() {
-        val = newVal;
-    }
+    vector<uint64_t>        val;
+    vector<uint64_t>        newVal;
+    vector<uint64_t>        initVal;
 
-    FanOutGates& getFanOutGates() {
-        return fanOut_gates;
-    }
+    vector<int>             fanoutBegin;
+    vector<int>             fanoutGates;
 
-    pair<bool, bool> getValues() {
-        return pair<bool, bool>(val, newVal);
-    }
+    // the words of newVal written since the last advanceTime and a flag per word
+    vector<int>             dirtyWords;
+    vector<bool>            isDirty;
 
-    hcmNode* getNode() {
-        return node;
+    static bool getBit(const vector<uint64_t>& bits, int net) {
+        return (bits[net / 64] >> (net % 64)) & 1;
     }
 
-    bool isInitVal() {
-        return init_val;
+    static void setBit(vector<uint64_t>& bits, int net, bool v) {
+        uint64_t mask = 1ULL << (net % 64);
+        bits[net / 64] = v ? (bits[net / 64] | mask) : (bits[net / 64] & ~mask);
     }
 
-    friend class NetTable;
-};
-
-/**
- * @brief Manages a table of net table entries.
- */
-class NetTable {
-    map<string, NetTableEntry> nets;
-
 public:
     NetTable() {};
 
     ~NetTable() {}
 
-    NetTableEntry* find(hcmNode* node) {
-        std::map<string, NetTableEntry>::iterator nte;
-        nte = nets.find(node->getName());
+    /**
+     * @brief Builds the table for all the nodes of the cell, in name order, and their fanout.
+     *
+     * @param cell The flat cell.
+     * @param gateQueue Gives the gate IDs of the fanout gates.
+     * @param vddName The node initialized to 1, all others are initialized to INIT_VAL.
+     */
+    void build(hcmCell* cell, GateQueue& gateQueue, const string& vddName) {
+        for (auto nI : cell->getNodes()) {
+            idByNode[nI.second] = nodes.size();
+            nodes.push_back(nI.second);
+        }
 
-        if (nte != nets.end()) {
-            return &(nte->second);
+        size_t numWords = (nodes.size() + 63) / 64;
+        val.assign(numWords, INIT_VAL ? ~0ULL : 0);
+        newVal = val;
+        initVal.assign(numWords, ~0ULL);
+        isDirty.assign(numWords, false);
+
+        fanoutBegin.push_back(0);
+        for (size_t n = 0; n < nodes.size(); n++) {
+            if (nodes[n]->getName() == vddName) {
+                setBit(val, n, 1);
+                setBit(newVal, n, 1);
+            }
+            std::map<std::string, hcmInstPort*>::const_iterator ipI;
+            for (ipI = nodes[n]->getInstPorts().begin(); ipI != nodes[n]->getInstPorts().end(); ipI++) {
+                if (ipI->second->getPort()->getDirection() == IN) {
+                    fanoutGates.push_back(gateQueue.getGateId(ipI->second->getInst()));
+                }
+            }
+            fanoutBegin.push_back(fanoutGates.size());
         }
-        return nullptr;
     }
 
-    FanOutGates getFanoutGates(hcmNode* node) {
-        NetTableEntry* nte;
-        nte = find(node);
+    int getNumNets() {
+        return nodes.size();
+    }
 
-        if (nte != nullptr) {
-            return nte->getFanOutGates();
+    /**
+     * @brief Gets the net ID of the node.
+     *
+     * @return the net ID, -1 if the node has no net
+     */
+    int getNetId(const hcmNode* node) {
+        auto nI = idByNode.find(node);
+        if (nI == idByNode.end()) {
+            return -1;
         }
+        return nI->second;
+    }
+
+    hcmNode* getNode(int net) {
+        return nodes[net];
+    }
 
-        FanOutGates fanout_gates;
-        std::map<std::string, hcmInstPort*>::const_iterator ipI;
+    pair<bool, bool> getValues(int net) {
+        return pair<bool, bool>(getBit(val, net), getBit(newVal, net));
+    }
 
-        for (ipI = node->getInstPorts().begin(); ipI != node->getInstPorts().end(); ipI++) {
-            if (ipI->second->getPort()->getDirection() == IN) {
-                fanout_gates.push_back(ipI->second->getInst());
-            }
-        }
-        return fanout_gates;
+    bool isInitVal(int net) {
+        return getBit(initVal, net);
     }
 
-    void update(hcmNode* node, bool newVal) {
-        NetTableEntry* nte;
-        nte = find(node);
+    const int* getFanoutBegin(int net) {
+        return fanoutGates.data() + fanoutBegin[net];
+    }
 
-        if (nte != nullptr) {
-            nte->update(newVal);
-        }
-        else {
-            nets.insert({ node->getName(), NetTableEntry(INIT_VAL, newVal, node, getFanoutGates(node), false) });
+    const int* getFanoutEnd(int net) {
+        return fanoutGates.data() + fanoutBegin[net + 1];
+    }
+
+    void update(int net, bool v) {
+        setBit(initVal, net, false);
+        setBit(newVal, net, v);
+        if (!isDirty[net / 64]) {
+            isDirty[net / 64] = true;
+            dirtyWords.push_back(net / 64);
         }
     }
 
+    /**
+     * @brief Makes the new values current, copying only the words written since the last call.
+     */
     void advanceTime() {
-        std::map<string, NetTableEntry>::iterator nte;
-
-        for (nte = nets.begin(); nte != nets.end(); nte++) {
-            nte->second.advanceTime();
+        for (auto w : dirtyWords) {
+            val[w] = newVal[w];
+            isDirty[w] = false;
         }
+        dirtyWords.clear();
     }
 
     void printNetTable() {
-        for (auto it : nets) {
-            cout << "NET: " << " node: " << it.first << " init_val: " << it.second.init_val << " value: " << it.second.val << " new value: " << it.second.newVal << endl;
+        for (size_t n = 0; n < nodes.size(); n++) {
+            cout << "NET: " << " node: " << nodes[n]->getName() << " init_val: " << isInitVal(n) << " value: " << getBit(val, n) << " new value: " << getBit(newVal, n) << endl;
         }
         cout << endl;
     }
@@ -317,196 +676,824 @@ public:
 };
 
 /**
- * @brief The main simulation class for the event-driven simulator.
+ * @brief A straight-line program of gate operations over a value array, one word per net,
+ * built once from the levelized gates and run on every vector. Each instruction is the opcode,
+ * the number of inputs, the destination net and the input nets.
  */
-class EventDrivenSim {
-    EventQueue    Event_Queue;
-    GateQueue     Gate_Queue;
-    NetTable      Net_Table;
-
-    vcdFormatter& vcd;
-    hcmSigVec&    parser;
-    set<string>   signals;
-    hcmCell*      flatCell;
-    set<string>&  globalNodes;
-    int  		  time;
+class GateProgram {
+    vector<int> code;
+    // the kernel of every instruction, the 64 pattern kernels of gatekernels.h, NULL for a DFF
+    vector<GateBlockFn> kernels;
+    GateBlockTable      table;
+    // the positions of the DFF instructions
+    vector<int> dffs;
 
 public:
-    EventDrivenSim(vcdFormatter& vcd, hcmSigVec& parser, hcmCell* flatCell, set<string>& globalNodes, int time) :
-        vcd(vcd), parser(parser), flatCell(flatCell), globalNodes(globalNodes), time(time) {
-        parser.getSignals(signals);
+    GateProgram() {
+        GateBlockKernels<uint64_t>::fill(table, "scalar");
     }
 
-    ~EventDrivenSim() {}
-
-    /**
-     * @brief Initializes the nodes in the circuit.
-     */
-    void initializeNodes() {
-        std::map<std::string, hcmNode*>::const_iterator nI;
-
-        for (auto nI : flatCell->getNodes()) {
-            hcmNode* node = nI.second;
-            bool initVal = node->getName() == "VDD" ? 1 : INIT_VAL;
-            if (globalNodes.find(node->getName()) != globalNodes.end()) {
-                Event_Queue.insert(Event(node, Event::UPDATE_EVENT, initVal));
-            }
-            Net_Table.nets.insert({ node->getName(), NetTableEntry(initVal, initVal, node, Net_Table.getFanoutGates(node)) });
-        }
+    void clear() {
+        code.clear();
+        kernels.clear();
+        dffs.clear();
     }
 
-    void CircuitInput(vector<pair<string, bool>> input_vector) {
-        for (auto input : input_vector) {
-            hcmNode* node = flatCell->getNode(input.first);
-            Event_Queue.insert(Event(node, Event::UPDATE_EVENT, input.second));
-        }
+    bool hasDffs() {
+        return !dffs.empty();
     }
 
-    bool updateEvent(Event event) {
-        NetTableEntry* nte;
-        nte = Net_Table.find(event.node);
+    /**
+     * @brief Number of instructions
+     */
+    size_t size() {
+        return kernels.size();
+    }
 
-        if (nte == nullptr) {
-            Net_Table.update(event.node, event.value);
-            return true;
+    /**
+     * @brief Appends an instruction, a BUFFER copies its input to the extra outputs of a gate.
+     *
+     * @return 0 on success, 1 if the gate has no kernel
+     */
+    int emit(GateOp op, const int* inputs, int numInputs, int dst) {
+        GateBlockFn fn = NULL;
+        if (op == DFF) {
+            dffs.push_back(code.size());
         }
         else {
-            pair<bool, bool> values = nte->getValues();
-            bool init_val = nte->isInitVal();
-            nte->update(event.value);
-
-            if ((event.value != values.second) || init_val) {
-                return true;
+            fn = table.fn[op][getKernelColumn(op, numInputs)];
+            if (fn == NULL) {
+                return 1;
             }
         }
-        return false;
+        kernels.push_back(fn);
+        code.push_back(op);
+        code.push_back(numInputs);
+        code.push_back(dst);
+        code.insert(code.end(), inputs, inputs + numInputs);
+        return 0;
     }
 
-    void evaluateEvent(Event event) {
-        FanOutGates fanout_gates = Net_Table.getFanoutGates(event.node);
-
-        for (auto gate : fanout_gates) {
-            auto gate_it = std::find(Gate_Queue.gates.begin(), Gate_Queue.gates.end(), gate);
-            if (gate_it == Gate_Queue.gates.end()) {
-                Gate_Queue.gates.push_back(gate);
+    /**
+     * @brief Runs the program once. Every bit position of the words is an independent evaluation.
+     * A DFF is evaluated like the event driven simulation does, only in a vector one of its inputs
+     * changed in, sampling the D value of the previous vector.
+     *
+     * @param v The net values, updated in place.
+     * @param prev The net values at the end of the previous vector, used by DFFs only.
+     * @param fired Per net, set once the DFF driving it was evaluated in this vector.
+     * @param first True on the first vector, when every DFF is evaluated.
+     */
+    void run(uint64_t* v, const uint64_t* prev, char* fired, bool first) {
+        const int* pc = code.data();
+        for (size_t k = 0; k < kernels.size(); k++) {
+            int n = pc[1];
+            int dst = pc[2];
+            const int* in = pc + 3;
+            pc = in + n;
+            if (kernels[k]) {
+                kernels[k](in, n, v, v + dst);
+                continue;
             }
+            if (!fired[dst] && !first && !inputsChanged(in, n, v, prev)) {
+                continue;
+            }
+            fired[dst] = 1;
+            v[dst] = dffKernel(v[in[0]], prev[in[1]], v[dst]);
         }
     }
 
     /**
-     * @brief Processes the events in the event queue.
+     * @brief Evaluates the DFFs an input of which changed only after the DFF ran, i.e. by the
+     * logic fed by the DFF outputs, so another run propagates their new values.
+     *
+     * @return true if a DFF output changed and the program has to run again
      */
-    void Event_Processor() {
-        list<Event> events = Event_Queue.events;
-        for (auto event : events) {
-            Event_Queue.remove(event);
-
-            if (event.type == Event::UPDATE_EVENT) {
-                if (updateEvent(event)) {
-                    Event_Queue.insert(Event(event.node, Event::EVALUATION_EVENT, event.value));
-                }
+    bool settleDffs(uint64_t* v, const uint64_t* prev, char* fired) {
+        bool changed = false;
+        for (size_t i = 0; i < dffs.size(); i++) {
+            const int* pc = code.data() + dffs[i];
+            int dst = pc[2];
+            const int* in = pc + 3;
+            if (!fired[dst] && !inputsChanged(in, pc[1], v, prev)) {
+                continue;
             }
-            else if (event.type == Event::EVALUATION_EVENT) {
-                evaluateEvent(event);
+            fired[dst] = 1;
+            uint64_t q = dffKernel(v[in[0]], prev[in[1]], v[dst]);
+            if (q != v[dst]) {
+                changed = true;
             }
         }
+        return changed;
     }
 
     /**
-     * @brief Processes the gates in the gate queue.
+     * @brief Writes the program as the body of a C++ function, one bitwise statement per instruction
+     * over the value array v.
+     *
+     * @return 0 on success, 1 if the program has a DFF
      */
-    void Gate_Processor() {
-        FanOutGates gates = Gate_Queue.gates;
-        for (auto gate : gates) {
-            pair<vector<bool>, vector<bool>> gate_inputs = GetGateInputs(gate);
-            bool gate_output = GetGateOutput(gate);
-            bool newVal = Gate_Queue.simulate(gate, gate_inputs.first, gate_inputs.second, gate_output);
-
-            std::map<std::string, hcmInstPort*>::const_iterator ipI;
-
-            for (ipI = gate->getInstPorts().begin(); ipI != gate->getInstPorts().end(); ipI++) {
-                if (ipI->second->getPort()->getDirection() == OUT) {
-                    hcmNode* node = ipI->second->getNode();
+    int writeCpp(ostream& os) {
+        for (size_t pc = 0; pc < code.size(); pc += 3 + code[pc + 1]) {
+            int n = code[pc + 1];
+            const int* in = &code[pc + 3];
+            const char* sep = "";
+            bool inverted = false;
+            switch (code[pc]) {
+                case BUFFER: break;
+                case NOT:    inverted = true; break;
+                case OR:     sep = " | "; break;
+                case NOR:    sep = " | "; inverted = true; break;
+                case AND:    sep = " & "; break;
+                case NAND:   sep = " & "; inverted = true; break;
+                case XOR:    sep = " ^ "; break;
+                default:     return 1;
+            }
+            os << "    v[" << code[pc + 2] << "] = " << (inverted ? "~(" : "");
+            for (int i = 0; i < n; i++) {
+                os << (i ? sep : "") << "v[" << in[i] << "]";
+            }
+            os << (inverted ? ");" : ";") << "\n";
+        }
+        return 0;
+    }
 
-                    if (updateEvent(Event(node, Event::UPDATE_EVENT, newVal))) {
-                        Event_Queue.insert(Event(node, Event::EVALUATION_EVENT, newVal));
-                    }
-                }
+private:
+    static bool inputsChanged(const int* in, int n, const uint64_t* v, const uint64_t* prev) {
+        for (int i = 0; i < n; i++) {
+            if (v[in[i]] != prev[in[i]]) {
+                return true;
             }
-            Gate_Queue.remove(gate);
         }
+        return false;
     }
+};
 
-    pair<vector<bool>, vector<bool>> GetGateInputs(hcmInstance* gate) {
-        pair<vector<bool>, vector<bool>> gate_inputs;
-        std::map<std::string, hcmInstPort*>::const_iterator ipI;
+/**
+ * @brief Evaluates a program compiled to native code on the value array, one word per net.
+ */
+typedef void (*JitWordFn)(uint64_t* v);
 
-        for (ipI = gate->getInstPorts().begin(); ipI != gate->getInstPorts().end(); ipI++) {
-            if (ipI->second->getPort()->getDirection() == IN) {
-                hcmNode* node = ipI->second->getNode();
-                NetTableEntry* nte = Net_Table.find(node);
+/**
+ * @brief Compiles generated C++ source into a shared object with the system compiler and loads it.
+ * The shared objects are cached by the hash of the source so repeated runs on the same netlist
+ * skip the compilation. The cache directory is $HCM_JIT_CACHE, /tmp/hcm_jit by default, and the
+ * compiler $CXX, g++ by default.
+ */
+class GateJit {
+    void*     handle;
+    JitWordFn fn;
 
-                if (nte) {
-                    pair<bool, bool> values = nte->getValues();
+public:
+    GateJit() : handle(NULL), fn(NULL) {}
 
-                    if (ipI->second->getPort()->getName().compare("CLK") == 0) {
-                        gate_inputs.first.insert(gate_inputs.first.begin(), values.first);
-                        gate_inputs.second.insert(gate_inputs.second.begin(), values.second);
-                    }
-                    else {
-                        gate_inputs.first.push_back(values.first);
-                        gate_inputs.second.push_back(values.second);
-                    }
-                }
-                else {
-                    gate_inputs.first.push_back(INIT_VAL);
-                    gate_inputs.second.push_back(INIT_VAL);
-                }
-            }
+    ~GateJit() {
+        if (handle) {
+            dlclose(handle);
         }
-        return gate_inputs;
     }
 
-    bool GetGateOutput(hcmInstance* gate) {
-        bool gate_output;
-        std::map<std::string, hcmInstPort*>::const_iterator ipI;
+    JitWordFn getFn() {
+        return fn;
+    }
+
+    /**
+     * @brief Quotes a path for the shell.
+     */
+    static string shellQuote(const string& path) {
+        string res = "'";
+        for (size_t i = 0; i < path.size(); i++) {
+            res += path[i] == '\'' ? string("'\\''") : string(1, path[i]);
+        }
+        return res + "'";
+    }
+
+    /**
+     * @brief Tells whether the path is a directory or a regular file, as asked, owned by the current
+     * user and not writable by the group or the others, so no other user could have planted it.
+     */
+    static bool isPrivate(const string& path, bool dir) {
+        struct stat st;
+        if ((dir ? stat(path.c_str(), &st) : lstat(path.c_str(), &st)) != 0) {
+            return false;
+        }
+        return (dir ? S_ISDIR(st.st_mode) : S_ISREG(st.st_mode)) && st.st_uid == getuid() &&
+               !(st.st_mode & (S_IWGRP | S_IWOTH));
+    }
 
-        for (ipI = gate->getInstPorts().begin(); ipI != gate->getInstPorts().end(); ipI++) {
-            if (ipI->second->getPort()->getDirection() == OUT) {
-                hcmNode* node = ipI->second->getNode();
-                NetTableEntry* nte = Net_Table.find(node);
+    /**
+     * @brief Gets the cache directory, $HCM_JIT_CACHE, $XDG_CACHE_HOME/hcm_jit or ~/.cache/hcm_jit,
+     * creating it readable by the current user only.
+     *
+     * @return 0 on success, 1 if it could not be created or is not private to the current user
+     */
+    static int getCacheDir(string& dir) {
+        if (getenv("HCM_JIT_CACHE")) {
+            dir = getenv("HCM_JIT_CACHE");
+        }
+        else {
+            string parent;
+            if (getenv("XDG_CACHE_HOME")) {
+                parent = getenv("XDG_CACHE_HOME");
+            }
+            else if (getenv("HOME")) {
+                parent = string(getenv("HOME")) + "/.cache";
+            }
+            else {
+                cerr << "-E- Set HCM_JIT_CACHE, XDG_CACHE_HOME or HOME for the native code cache" << endl;
+                return 1;
+            }
+            if (mkdir(parent.c_str(), 0700) != 0 && errno != EEXIST) {
+                cerr << "-E- Could not create: " << parent << " " << strerror(errno) << endl;
+                return 1;
+            }
+            dir = parent + "/hcm_jit";
+        }
+        if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+            cerr << "-E- Could not create the native code cache: " << dir << " " << strerror(errno) << endl;
+            return 1;
+        }
+        if (!isPrivate(dir, true)) {
+            cerr << "-E- The native code cache: " << dir
+                 << " must be a directory owned by the current user and writable by no one else" << endl;
+            return 1;
+        }
+        return 0;
+    }
 
-                if (nte) {
-                    pair<bool, bool> values = nte->getValues();
-                    gate_output = values.second;
+    /**
+     * @brief Gets the shared object of the source from the cache, compiling it on a miss, and loads
+     * its function.
+     *
+     * @param source The C++ source, defining extern "C" void name(uint64_t* v).
+     * @param name The name of the function.
+     * @return 0 on success, 1 if the source could not be compiled or loaded
+     */
+    int load(const string& source, const char* name) {
+        string dir;
+        if (getCacheDir(dir)) {
+            return 1;
+        }
+        const char* cxx = getenv("CXX") ? getenv("CXX") : "g++";
+        string cmd = string(cxx) + " -O2 -shared -fPIC";
+
+        // FNV-1a over the compile command and the source
+        uint64_t hash = 14695981039346656037ULL;
+        string key = cmd + "\n" + source;
+        for (size_t i = 0; i < key.size(); i++) {
+            hash = (hash ^ (unsigned char)key[i]) * 1099511628211ULL;
+        }
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+        string base = dir + "/" + hex;
+        string so = base + ".so";
+
+        struct stat st;
+        if (lstat(so.c_str(), &st) == 0) {
+            cout << "-I- Using cached native code: " << so << endl;
+        }
+        else {
+            string src = base + ".cc";
+            ofstream os(src.c_str());
+            os << source;
+            os.close();
+            if (!os) {
+                cerr << "-E- Could not write generated source: " << src << endl;
+                return 1;
+            }
+            // build under a temporary name so concurrent runs never load a partial file
+            ostringstream tmp;
+            tmp << so << ".tmp" << getpid();
+            string log = base + ".log";
+            cmd += " -o " + shellQuote(tmp.str()) + " " + shellQuote(src) + " > " + shellQuote(log) + " 2>&1";
+            cout << "-I- Compiling native code: " << cmd << endl;
+            if (system(cmd.c_str()) != 0 || rename(tmp.str().c_str(), so.c_str()) != 0) {
+                cerr << "-E- Could not compile generated source: " << src << " see: " << log << endl;
+                unlink(tmp.str().c_str());
+                return 1;
+            }
+        }
+
+        if (!isPrivate(so, false)) {
+            cerr << "-E- Refusing to load: " << so
+                 << " it must be a regular file owned by the current user and writable by no one else" << endl;
+            return 1;
+        }
+        handle = dlopen(so.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle == NULL) {
+            cerr << "-E- Could not load: " << so << " " << dlerror() << endl;
+            return 1;
+        }
+        fn = (JitWordFn)dlsym(handle, name);
+        if (fn == NULL) {
+            cerr << "-E- Could not find: " << name << " in: " << so << endl;
+            return 1;
+        }
+        return 0;
+    }
+};
+
+// the fewest gates in a time step, and in a wave of it, worth evaluating on the thread pool
+const size_t PARALLEL_MIN_GATES = 256;
+const int PARALLEL_MIN_WAVE = 128;
+
+/**
+ * @brief A pool of threads running a range of items at a time. Every thread starts on its own slice
+ * of the range and steals chunks from the slices of the others once done, so the items get spread
+ * over the threads no matter how uneven they are. The caller thread works too.
+ */
+class GateThreadPool {
+public:
+    typedef void (*JobFn)(void* ctx, int begin, int end);
+
+private:
+    // a slice of the range, the owner and the thieves claim chunks of it by the shared cursor
+    struct Slice {
+        std::atomic<int> next;
+        int end;
+        char pad[64 - sizeof(std::atomic<int>) - sizeof(int)];
+    };
+
+    vector<std::thread>     workers;
+    vector<Slice>           slices;
+    JobFn                   job;
+    void*                   jobCtx;
+    int                     grain;
+    std::atomic<unsigned>   generation;
+    std::atomic<int>        busy;
+    bool                    quit;
+    std::mutex              mutex;
+    std::condition_variable wake;
+
+    void work(int self) {
+        int n = slices.size();
+        for (int k = 0; k < n; k++) {
+            Slice& s = slices[(self + k) % n];
+            for (;;) {
+                int begin = s.next.fetch_add(grain);
+                if (begin >= s.end) {
+                    break;
                 }
-                else {
-                    gate_output = INIT_VAL;
+                job(jobCtx, begin, min(begin + grain, s.end));
+            }
+        }
+    }
+
+    void workerLoop(int self) {
+        unsigned seen = 0;
+        for (;;) {
+            // spin shortly for the next job of the same time step before sleeping
+            for (int spin = 0; spin < 1000 && generation.load(std::memory_order_acquire) == seen; spin++) {
+                std::this_thread::yield();
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || generation.load(std::memory_order_acquire) != seen; });
+                if (quit) {
+                    return;
                 }
             }
+            seen = generation.load(std::memory_order_acquire);
+            work(self);
+            busy.fetch_sub(1, std::memory_order_release);
         }
-        return gate_output;
     }
 
-    void WriteFinalOutput() {
-        const hcmNode* node;
+public:
+    GateThreadPool(int numThreads) : slices(numThreads), job(NULL), jobCtx(NULL), grain(1), generation(0), busy(0), quit(false) {
+        for (int i = 1; i < numThreads; i++) {
+            workers.push_back(std::thread(&GateThreadPool::workerLoop, this, i));
+        }
+    }
+
+    ~GateThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i].join();
+        }
+    }
+
+    int size() {
+        return slices.size();
+    }
+
+    /**
+     * @brief Runs fn on all the items 0 to numItems - 1 and returns once all are done.
+     *
+     * @param numItems The number of items.
+     * @param fn Called with ctx and a chunk [begin, end) of the items, from any thread.
+     */
+    void run(int numItems, JobFn fn, void* ctx) {
+        int n = slices.size();
+        grain = max(16, numItems / (n * 8));
+        for (int i = 0; i < n; i++) {
+            slices[i].next.store((long long)numItems * i / n, std::memory_order_relaxed);
+            slices[i].end = (long long)numItems * (i + 1) / n;
+        }
+        job = fn;
+        jobCtx = ctx;
+        busy.store(n - 1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            generation.fetch_add(1, std::memory_order_release);
+        }
+        wake.notify_all();
+        work(0);
+        while (busy.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+/**
+ * @brief The main simulation class for the event-driven simulator.
+ */
+class EventDrivenSim {
+    EventQueue    Event_Queue;
+    GateQueue     Gate_Queue;
+    NetTable      Net_Table;
+    GateProgram   Gate_Program;
+    GateJit       Gate_Jit;
+
+    vcdFormatter* vcd;
+    hcmSigVec&    parser;
+    hcmStimulus&  stim;
+    set<string>   signals;
+    hcmCell*      flatCell;
+    set<string>&  globalNodes;
+    int  		  time;
+    // the nets written to the VCD and their signal handles
+    vector<pair<int, int>> dumpedNets;
+    // the input signals bound to the nets they drive, as (signal index, net ID)
+    vector<pair<int, int>> inputBindings;
+    // the gates in level order for the pattern parallel and the compiled code simulation
+    vector<int> levelOrder;
+    // the kernels of the pattern parallel simulation and the kernel of every gate in level order
+    GateBlockTable      blockTable;
+    vector<GateBlockFn> blockFns;
+    // the native code of the compiled program, NULL to run the program itself
+    JitWordFn jitFn;
+    // the events and the gates of the time step being processed
+    vector<Event> stepEvents;
+    vector<int>   stepGates;
+    // the parallel gate processor: the thread pool, the gates of the step by wave and their results
+    GateThreadPool* threadPool;
+    vector<int>     stepWave;
+    vector<int>     waveBegin;
+    vector<int>     waveFill;
+    vector<int>     waveOrder;
+    int             stepWaveFirst;
+    vector<char>    stepResults;
+    vector<char>    stepChanged;
+    vector<int>     changedBegin;
+    // per net, the last wave writing and reading it in this step, valid if its stamp is the step epoch
+    vector<int>      lastWrite;
+    vector<int>      lastRead;
+    vector<unsigned> netStamp;
+    unsigned         stepEpoch;
+    // without a waveform the settled values of all nets are only summed into the checksum, for benchmarks
+    uint64_t checksum;
+
+public:
+    EventDrivenSim(hcmSigVec& parser, hcmStimulus& stim, hcmCell* flatCell, set<string>& globalNodes, int time) :
+        vcd(NULL), parser(parser), stim(stim), flatCell(flatCell), globalNodes(globalNodes), time(time),
+        jitFn(NULL), threadPool(NULL), stepWaveFirst(0), stepEpoch(0), checksum(14695981039346656037ULL) {
+        parser.getSignals(signals);
+    }
+
+    ~EventDrivenSim() {
+        delete threadPool;
+    }
+
+    /**
+     * @brief Sets the number of threads evaluating the gates of a time step, 1 for the serial processor.
+     */
+    void setThreads(int numThreads) {
+        delete threadPool;
+        threadPool = (numThreads > 1) ? new GateThreadPool(numThreads) : NULL;
+    }
+
+    uint64_t getChecksum() {
+        return checksum;
+    }
+
+    /**
+     * @brief Initializes the nodes in the circuit.
+     */
+    void initializeNodes() {
+        // every node gets its net ID up front, events are keyed by it
+        Net_Table.build(flatCell, Gate_Queue, "VDD");
+        compileGates();
+
+        for (int net = 0; net < Net_Table.getNumNets(); net++) {
+            hcmNode* node = Net_Table.getNode(net);
+            if (globalNodes.find(node->getName()) != globalNodes.end()) {
+                Event_Queue.insert(Event(node, Event::UPDATE_EVENT, Net_Table.getValues(net).second, net));
+            }
+        }
+    }
+
+    /**
+     * @brief Builds the tables and binds the inputs, before any waveform is created so a circuit
+     * that cannot be simulated leaves no file behind.
+     *
+     * @return 0 on success, 1 if no signal could be bound
+     */
+    int prepare() {
+        initializeNodes();
+
+        // bind the signals to their nets by index, the stimulus produces the vectors packed
+        return bindInputs();
+    }
+
+    /**
+     * @brief Sets the waveform the settled values are written to and resolves the VCD handles of the nets once.
+     */
+    void setWaveform(vcdFormatter* waveform) {
+        vcd = waveform;
+        dumpedNets.clear();
         list<const hcmInstance*> parents;
-        std::map<string, NetTableEntry>::iterator nte;
+        for (int net = 0; net < Net_Table.getNumNets(); net++) {
+            hcmNodeCtx ctx(parents, Net_Table.getNode(net));
+            int handle = vcd->getHandle(&ctx);
+            if (handle >= 0) {
+                dumpedNets.push_back(make_pair(net, handle));
+            }
+        }
+    }
+
+    /**
+     * @brief Binds every input signal index of the vectors to the net ID of its node, once before simulating.
+     *
+     * @return 0 on success, 1 if no signal could be bound
+     */
+    int bindInputs() {
+        for (set<string>::iterator sig = signals.begin(); sig != signals.end(); sig++) {
+            int idx = parser.getSignalIdx(*sig);
+            hcmNode* node = flatCell->getNode(*sig);
+            int net = (node != NULL) ? Net_Table.getNetId(node) : -1;
+            if (idx < 0 || net < 0) {
+                cerr << "-W- Signal: " << *sig << " has no node in cell: " << flatCell->getName() << " ignored" << endl;
+                continue;
+            }
+            inputBindings.push_back(make_pair(idx, net));
+        }
+        return inputBindings.empty() && !signals.empty();
+    }
+
+    /**
+     * @brief Applies the given vector to the bound input nets.
+     *
+     * @param words The packed bits of the vector, bit i is the value of signal index i.
+     */
+    void CircuitInput(const uint64_t* words) {
+        for (size_t i = 0; i < inputBindings.size(); i++) {
+            int net = inputBindings[i].second;
+            int idx = inputBindings[i].first;
+            bool val = (words[idx / 64] >> (idx % 64)) & 1;
+            Event_Queue.insert(Event(Net_Table.getNode(net), Event::UPDATE_EVENT, val, net));
+        }
+    }
+
+    bool updateEvent(Event event) {
+        pair<bool, bool> values = Net_Table.getValues(event.net);
+        bool init_val = Net_Table.isInitVal(event.net);
+        Net_Table.update(event.net, event.value);
+
+        if ((event.value != values.second) || init_val) {
+            return true;
+        }
+        return false;
+    }
+
+    void evaluateEvent(Event event) {
+        const int* end = Net_Table.getFanoutEnd(event.net);
+        for (const int* gate = Net_Table.getFanoutBegin(event.net); gate != end; gate++) {
+            Gate_Queue.schedule(*gate);
+        }
+    }
+
+    /**
+     * @brief Processes the events of the next time step in the event queue.
+     */
+    void Event_Processor() {
+        Event_Queue.popNext(stepEvents);
+        for (auto& event : stepEvents) {
+            if (event.type == Event::UPDATE_EVENT) {
+                if (updateEvent(event)) {
+                    Event_Queue.insert(Event(event.node, Event::EVALUATION_EVENT, event.value, event.net));
+                }
+            }
+            else if (event.type == Event::EVALUATION_EVENT) {
+                evaluateEvent(event);
+            }
+        }
+    }
+
+    /**
+     * @brief Processes the gates in the gate queue.
+     */
+    void Gate_Processor() {
+        Gate_Queue.drain(stepGates);
+        if (threadPool && stepGates.size() >= PARALLEL_MIN_GATES) {
+            Parallel_Gate_Processor();
+            return;
+        }
+        for (auto id : stepGates) {
+            const GateQueue::GateRecord& g = Gate_Queue.getRecord(id);
+            bool newVal = Gate_Queue.simulate(g, Net_Table.val.data(), Net_Table.newVal.data());
+
+            const int* outputs = Gate_Queue.getPins(g) + g.numInputs;
+            for (int i = 0; i < g.numOutputs; i++) {
+                int net = outputs[i];
+                hcmNode* node = Net_Table.getNode(net);
+
+                if (updateEvent(Event(node, Event::UPDATE_EVENT, newVal, net))) {
+                    Event_Queue.insert(Event(node, Event::EVALUATION_EVENT, newVal, net));
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Evaluates the gates of the chunk of the current wave, called by the pool threads.
+     * Only reads the net values, every gate writes its own result slot.
+     */
+    static void evalWaveChunk(void* ctx, int begin, int end) {
+        EventDrivenSim* sim = (EventDrivenSim*)ctx;
+        const uint64_t* val = sim->Net_Table.val.data();
+        const uint64_t* newVal = sim->Net_Table.newVal.data();
+        for (int i = begin; i < end; i++) {
+            int pos = sim->waveOrder[sim->stepWaveFirst + i];
+            sim->stepResults[pos] = sim->Gate_Queue.simulate(sim->Gate_Queue.getRecord(sim->stepGates[pos]), val, newVal);
+        }
+    }
+
+    /**
+     * @brief Marks the net as seen in this step, clearing its last writer and reader.
+     */
+    void touchNet(int net) {
+        if (netStamp[net] != stepEpoch) {
+            netStamp[net] = stepEpoch;
+            lastWrite[net] = -1;
+            lastRead[net] = 0;
+        }
+    }
+
+    /**
+     * @brief Processes the gates in the gate queue on the thread pool, with the same result as the
+     * serial processor. The serial processor lets a gate see the outputs updated by the gates before
+     * it in the queue, so the gates are split into waves: a gate goes after the earlier gates writing
+     * a net it reads or writes, and not before the earlier gates reading a net it writes. The gates of
+     * a wave only read the net values and are evaluated in parallel, then their outputs are updated
+     * in queue order, and the evaluation events are scheduled in queue order once all waves are done.
+     */
+    void Parallel_Gate_Processor() {
+        int numGates = stepGates.size();
+        if (netStamp.size() != (size_t)Net_Table.getNumNets()) {
+            netStamp.assign(Net_Table.getNumNets(), 0);
+            lastWrite.resize(Net_Table.getNumNets());
+            lastRead.resize(Net_Table.getNumNets());
+        }
+        if (++stepEpoch == 0) {
+            std::fill(netStamp.begin(), netStamp.end(), 0);
+            stepEpoch = 1;
+        }
+
+        // the wave of every gate by the hazards with the gates before it
+        stepWave.resize(numGates);
+        changedBegin.resize(numGates + 1);
+        changedBegin[0] = 0;
+        int numWaves = 0;
+        for (int pos = 0; pos < numGates; pos++) {
+            const GateQueue::GateRecord& g = Gate_Queue.getRecord(stepGates[pos]);
+            const int* pins = Gate_Queue.getPins(g);
+            // a DFF reads its own output to hold it
+            int numReads = (g.op == DFF) ? g.numInputs + g.numOutputs : g.numInputs;
+            int wave = 0;
+            for (int i = 0; i < g.numInputs + g.numOutputs; i++) {
+                touchNet(pins[i]);
+                wave = max(wave, lastWrite[pins[i]] + 1);
+                if (i >= g.numInputs) {
+                    wave = max(wave, lastRead[pins[i]]);
+                }
+            }
+            for (int i = 0; i < numReads; i++) {
+                lastRead[pins[i]] = max(lastRead[pins[i]], wave);
+            }
+            for (int i = g.numInputs; i < g.numInputs + g.numOutputs; i++) {
+                lastWrite[pins[i]] = wave;
+            }
+            stepWave[pos] = wave;
+            numWaves = max(numWaves, wave + 1);
+            changedBegin[pos + 1] = changedBegin[pos] + g.numOutputs;
+        }
+
+        // counting sort by wave, keeping the queue order within a wave
+        waveBegin.assign(numWaves + 1, 0);
+        for (int pos = 0; pos < numGates; pos++) {
+            waveBegin[stepWave[pos] + 1]++;
+        }
+        for (int w = 0; w < numWaves; w++) {
+            waveBegin[w + 1] += waveBegin[w];
+        }
+        waveOrder.resize(numGates);
+        waveFill.assign(waveBegin.begin(), waveBegin.end() - 1);
+        for (int pos = 0; pos < numGates; pos++) {
+            waveOrder[waveFill[stepWave[pos]]++] = pos;
+        }
+
+        stepResults.resize(numGates);
+        stepChanged.resize(changedBegin[numGates]);
+        for (int w = 0; w < numWaves; w++) {
+            stepWaveFirst = waveBegin[w];
+            int count = waveBegin[w + 1] - waveBegin[w];
+            if (count >= PARALLEL_MIN_WAVE) {
+                threadPool->run(count, &evalWaveChunk, this);
+            }
+            else {
+                evalWaveChunk(this, 0, count);
+            }
+
+            for (int i = waveBegin[w]; i < waveBegin[w + 1]; i++) {
+                int pos = waveOrder[i];
+                const GateQueue::GateRecord& g = Gate_Queue.getRecord(stepGates[pos]);
+                const int* outputs = Gate_Queue.getPins(g) + g.numInputs;
+                for (int o = 0; o < g.numOutputs; o++) {
+                    int net = outputs[o];
+                    stepChanged[changedBegin[pos] + o] =
+                        updateEvent(Event(Net_Table.getNode(net), Event::UPDATE_EVENT, stepResults[pos], net));
+                }
+            }
+        }
+
+        for (int pos = 0; pos < numGates; pos++) {
+            const GateQueue::GateRecord& g = Gate_Queue.getRecord(stepGates[pos]);
+            const int* outputs = Gate_Queue.getPins(g) + g.numInputs;
+            for (int o = 0; o < g.numOutputs; o++) {
+                if (stepChanged[changedBegin[pos] + o]) {
+                    Event_Queue.insert(Event(Net_Table.getNode(outputs[o]), Event::EVALUATION_EVENT, stepResults[pos], outputs[o]));
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Compiles every gate into its record of opcode and pin net IDs.
+     */
+    void compileGates() {
+        vector<int> inputs;
+        vector<int> outputs;
+        for (int id = 0; id < (int)Gate_Queue.gateById.size(); id++) {
+            hcmInstance* gate = Gate_Queue.getGate(id);
+            inputs.clear();
+            outputs.clear();
+            std::map<std::string, hcmInstPort*>::const_iterator ipI;
+            for (ipI = gate->getInstPorts().begin(); ipI != gate->getInstPorts().end(); ipI++) {
+                int net = Net_Table.getNetId(ipI->second->getNode());
+                if (net < 0) {
+                    cerr << "-F- Instance port: " << ipI->second->getName() << " is not connected to a net" << endl;
+                    exit(1);
+                }
+                if (ipI->second->getPort()->getDirection() == OUT) {
+                    outputs.push_back(net);
+                }
+                else if (ipI->second->getPort()->getDirection() == IN) {
+                    if (ipI->second->getPort()->getName() == "CLK") {
+                        inputs.insert(inputs.begin(), net);
+                    }
+                    else {
+                        inputs.push_back(net);
+                    }
+                }
+            }
+            Gate_Queue.compile(id, inputs, outputs);
+        }
+    }
 
-        for (nte = Net_Table.nets.begin(); nte != Net_Table.nets.end(); nte++) {
-            node = nte->second.getNode();
-            hcmNodeCtx* ctx = new hcmNodeCtx(parents, node);
-            vcd.changeValue(ctx, nte->second.getValues().second);
+    void WriteFinalOutput() {
+        if (vcd == NULL) {
+            for (size_t w = 0; w < Net_Table.newVal.size(); w++) {
+                checksum = (checksum ^ Net_Table.newVal[w]) * 1099511628211ULL;
+            }
+            return;
+        }
+        for (size_t i = 0; i < dumpedNets.size(); i++) {
+            vcd->changeValue(dumpedNets[i].second, Net_Table.getValues(dumpedNets[i].first).second);
         }
     }
 
     /**
      * @brief Simulates a vector of inputs.
      *
-     * @param input_vector The vector of input values.
+     * @param words The packed bits of the vector.
      */
-    void SimulateVector(vector<pair<string, bool>> input_vector) {
-        CircuitInput(input_vector);
+    void SimulateVector(const uint64_t* words) {
+        CircuitInput(words);
         while (!Event_Queue.empty()) {
             Event_Processor();
             if (!Gate_Queue.empty()) {
@@ -521,28 +1508,569 @@ public:
      * @brief Simulates the entire circuit.
      */
     void Simulate() {
-        initializeNodes();
+        vector<uint64_t> words(stim.getWordsPerVector());
+        while (stim.nextVector(words.data()) == 0) {
+            // simulate the vector
+            SimulateVector(words.data());
 
-        // reading each vector
-        while (parser.readVector() == 0) {
-            // set the inputs to the values from the input vector.
-            vector<pair<string, bool>> in_vector;
+            if (vcd) {
+                vcd->changeTime(time++);
+            }
+        }
+    }
 
-            for (set<string>::iterator sig = signals.begin(); sig != signals.end(); sig++) {
-                string name = (*sig);
-                bool val;
-                parser.getSigValue(name, val);
-                in_vector.push_back(pair<string, bool>(name, val));
+    /**
+     * @brief Orders the gates so every gate comes after the gates driving its inputs. Only the gates
+     * reachable from the inputs and the global nets are ordered, the others are never evaluated by
+     * the event driven simulation either. A DFF depends only on its CLK pin since it samples the D
+     * value of the previous vector. The clock of a DFF has to come straight from an input or a
+     * global net, a clock driven by logic may glitch within a vector and the glitch is seen by the
+     * event driven simulation only.
+     *
+     * @param allowDff True if the caller handles DFFs.
+     * @return 0 on success, 1 if the circuit has a DFF and allowDff is false, a DFF clocked by
+     * logic or a combinational loop
+     */
+    int levelize(bool allowDff = false) {
+        int numGates = Gate_Queue.records.size();
+        int numNets = Net_Table.getNumNets();
+        vector<int> driver(numNets, -1);
+        // the nets driven by a gate or a DFF
+        vector<char> drivenNet(numNets, 0);
+        for (int id = 0; id < numGates; id++) {
+            const GateQueue::GateRecord& g = Gate_Queue.records[id];
+            if (g.op == DFF && !allowDff) {
+                cerr << "-E- Levelized simulation supports combinational circuits only, found DFF: "
+                     << Gate_Queue.getGate(id)->getName() << endl;
+                return 1;
+            }
+            const int* pins = Gate_Queue.getPins(g);
+            for (int i = 0; i < g.numOutputs; i++) {
+                drivenNet[pins[g.numInputs + i]] = 1;
+                if (g.op != DFF) {
+                    driver[pins[g.numInputs + i]] = id;
+                }
             }
+        }
 
-            // simulate the vector
-            SimulateVector(in_vector);
+        vector<char> inputNet(numNets, 0);
+        for (size_t i = 0; i < inputBindings.size(); i++) {
+            inputNet[inputBindings[i].second] = 1;
+        }
+        for (int id = 0; id < numGates; id++) {
+            const GateQueue::GateRecord& g = Gate_Queue.records[id];
+            if (g.op != DFF || !g.numInputs) {
+                continue;
+            }
+            int clk = Gate_Queue.getPins(g)[0];
+            if (drivenNet[clk] && !inputNet[clk] &&
+                globalNodes.find(Net_Table.getNode(clk)->getName()) == globalNodes.end()) {
+                cerr << "-E- Levelized simulation needs DFF clocks driven by inputs, the clock of DFF: "
+                     << Gate_Queue.getGate(id)->getName() << " is driven by logic" << endl;
+                return 1;
+            }
+        }
 
-            vcd.changeTime(time++);
+        // the nets that ever get an event and the gates they reach
+        vector<char> activeNet(numNets, 0);
+        vector<char> activeGate(numGates, 0);
+        vector<int> front;
+        for (int net = 0; net < numNets; net++) {
+            if (inputNet[net]) {
+                front.push_back(net);
+            }
         }
+        for (int net = 0; net < numNets; net++) {
+            if (globalNodes.find(Net_Table.getNode(net)->getName()) != globalNodes.end()) {
+                front.push_back(net);
+            }
+        }
+        while (!front.empty()) {
+            int net = front.back();
+            front.pop_back();
+            if (activeNet[net]) {
+                continue;
+            }
+            activeNet[net] = 1;
+            const int* end = Net_Table.getFanoutEnd(net);
+            for (const int* gate = Net_Table.getFanoutBegin(net); gate != end; gate++) {
+                if (activeGate[*gate]) {
+                    continue;
+                }
+                activeGate[*gate] = 1;
+                const GateQueue::GateRecord& g = Gate_Queue.records[*gate];
+                const int* pins = Gate_Queue.getPins(g);
+                front.insert(front.end(), pins + g.numInputs, pins + g.numInputs + g.numOutputs);
+            }
+        }
+
+        // Kahn's algorithm over the active gates, counting the inputs driven by other gates
+        vector<int> pending(numGates, 0);
+        vector<vector<int> > dependents(numGates);
+        int numActive = 0;
+        levelOrder.clear();
+        for (int id = 0; id < numGates; id++) {
+            if (!activeGate[id]) {
+                continue;
+            }
+            numActive++;
+            const GateQueue::GateRecord& g = Gate_Queue.records[id];
+            const int* pins = Gate_Queue.getPins(g);
+            int numDeps = (g.op == DFF) ? min(g.numInputs, 1) : g.numInputs;
+            for (int i = 0; i < numDeps; i++) {
+                if (driver[pins[i]] >= 0 && activeGate[driver[pins[i]]]) {
+                    pending[id]++;
+                    dependents[driver[pins[i]]].push_back(id);
+                }
+            }
+            if (!pending[id]) {
+                levelOrder.push_back(id);
+            }
+        }
+        for (size_t l = 0; l < levelOrder.size(); l++) {
+            const vector<int>& deps = dependents[levelOrder[l]];
+            for (size_t d = 0; d < deps.size(); d++) {
+                if (--pending[deps[d]] == 0) {
+                    levelOrder.push_back(deps[d]);
+                }
+            }
+        }
+        if ((int)levelOrder.size() != numActive) {
+            cerr << "-E- Levelized simulation found a combinational loop through "
+                 << numActive - levelOrder.size() << " gates" << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Compiles the levelized gates into the straight-line program.
+     *
+     * @return 0 on success, 1 if a gate is not supported
+     */
+    int compileProgram() {
+        Gate_Program.clear();
+        for (size_t l = 0; l < levelOrder.size(); l++) {
+            const GateQueue::GateRecord& g = Gate_Queue.records[levelOrder[l]];
+            const int* pins = Gate_Queue.getPins(g);
+            // a buffer or an inverter is driven by its first input only
+            int numInputs = (g.op == BUFFER || g.op == NOT) ? 1 : g.numInputs;
+            int column = g.op < UNSUPPORTED ? getKernelColumn(g.op, g.numInputs) : 0;
+            if (!column || (g.numOutputs && Gate_Program.emit(g.op, pins, numInputs, pins[g.numInputs]))) {
+                cerr << "-E- Gate " << Gate_Queue.getGate(levelOrder[l])->getName()
+                     << " is not supported by the compiled code simulator" << endl;
+                return 1;
+            }
+            for (int i = 1; i < g.numOutputs; i++) {
+                Gate_Program.emit(BUFFER, pins + g.numInputs, 1, pins[g.numInputs + i]);
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Levelizes the circuit and compiles the program of the compiled code simulation, before
+     * any waveform is created.
+     *
+     * @param width 1 to run the program per vector, DFFs are supported, or 64 to run it on 64
+     * vectors at a time, for combinational circuits only.
+     * @param jit True to compile the program to native code and run that instead, with width 64.
+     * @return 0 on success, 1 if the circuit cannot be levelized or compiled
+     */
+    int prepareCompiled(int width, bool jit = false) {
+        if (levelize(width == 1) || compileProgram()) {
+            return 1;
+        }
+        jitFn = NULL;
+        if (jit) {
+            ostringstream source;
+            source << "// generated by event_sim, one statement per gate in level order\n"
+                   << "#include <stdint.h>\n"
+                   << "extern \"C\" void hcmJitEval(uint64_t* v) {\n";
+            if (Gate_Program.writeCpp(source)) {
+                cerr << "-E- Native code supports combinational circuits only" << endl;
+                return 1;
+            }
+            source << "}\n";
+            if (Gate_Jit.load(source.str(), "hcmJitEval")) {
+                return 1;
+            }
+            jitFn = Gate_Jit.getFn();
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Simulates the entire circuit with the compiled program, evaluating every levelized gate
+     * on every vector instead of following events. The settled values are the ones the event driven
+     * simulation writes. Call prepareCompiled first with the same width.
+     */
+    void SimulateCompiled(int width) {
+        cout << "-I- Compiled " << Gate_Program.size() << " instructions, running "
+             << width << (width == 1 ? " vector" : " vectors") << " at a time" << endl;
+
+        // a net holds all ones or all zeros per vector, or one bit per vector of the word
+        int numNets = Net_Table.getNumNets();
+        vector<uint64_t> v(numNets);
+        vector<uint64_t> prev;
+        vector<char> fired(numNets, 0);
+        for (int net = 0; net < numNets; net++) {
+            v[net] = Net_Table.getValues(net).second ? ~0ULL : 0;
+        }
+        prev = v;
+
+        // the vectors of a vector file are taken 64 at a time from its signal-major words
+        hcmSigVec* vecFile = (width > 1) ? stim.getVectorFile() : NULL;
+        int firstVec = 0;
+        vector<uint64_t> words(stim.getWordsPerVector());
+        bool first = true;
+        for (;;) {
+            int numPatterns = 0;
+            if (vecFile) {
+                numPatterns = min(width, vecFile->getNumVectors() - firstVec);
+                for (size_t i = 0; numPatterns > 0 && i < inputBindings.size(); i++) {
+                    v[inputBindings[i].second] = vecFile->getSignalWords(inputBindings[i].first)[firstVec / 64];
+                }
+                firstVec += numPatterns;
+            }
+            else {
+                if (width > 1) {
+                    for (size_t i = 0; i < inputBindings.size(); i++) {
+                        v[inputBindings[i].second] = 0;
+                    }
+                }
+                for (; numPatterns < width && stim.nextVector(words.data()) == 0; numPatterns++) {
+                    for (size_t i = 0; i < inputBindings.size(); i++) {
+                        int idx = inputBindings[i].first;
+                        uint64_t bit = (words[idx / 64] >> (idx % 64)) & 1;
+                        if (width > 1) {
+                            v[inputBindings[i].second] |= bit << numPatterns;
+                        }
+                        else {
+                            v[inputBindings[i].second] = bit ? ~0ULL : 0;
+                        }
+                    }
+                }
+            }
+            if (!numPatterns) {
+                break;
+            }
+
+            if (jitFn) {
+                jitFn(v.data());
+            }
+            else if (Gate_Program.hasDffs()) {
+                std::fill(fired.begin(), fired.end(), 0);
+                Gate_Program.run(v.data(), prev.data(), fired.data(), first);
+                while (Gate_Program.settleDffs(v.data(), prev.data(), fired.data())) {
+                    Gate_Program.run(v.data(), prev.data(), fired.data(), first);
+                }
+                prev = v;
+            }
+            else {
+                Gate_Program.run(v.data(), NULL, NULL, first);
+            }
+            first = false;
+
+            for (int k = 0; k < numPatterns; k++) {
+                for (size_t i = 0; i < dumpedNets.size(); i++) {
+                    vcd->changeValue(dumpedNets[i].second, (v[dumpedNets[i].first] >> k) & 1);
+                }
+                vcd->changeTime(time++);
+            }
+        }
+    }
+
+    /**
+     * @brief Gets the block kernel of every gate in level order.
+     *
+     * @return 0 on success, 1 if a gate has no pattern parallel kernel
+     */
+    int getBlockFns(const GateBlockTable& t, vector<GateBlockFn>& fns) {
+        fns.resize(levelOrder.size());
+        for (size_t l = 0; l < levelOrder.size(); l++) {
+            const GateQueue::GateRecord& g = Gate_Queue.records[levelOrder[l]];
+            fns[l] = g.op < UNSUPPORTED ? t.fn[g.op][getKernelColumn(g.op, g.numInputs)] : NULL;
+            if (fns[l] == NULL) {
+                cerr << "-E- Gate " << Gate_Queue.getGate(levelOrder[l])->getName()
+                     << " is not supported by the pattern parallel simulator" << endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Fills every net with its initial value in all the patterns of a block.
+     */
+    void initBlocks(int blockWords, vector<uint64_t>& netWords) {
+        netWords.assign((size_t)Net_Table.getNumNets() * blockWords, 0);
+        for (int net = 0; net < Net_Table.getNumNets(); net++) {
+            if (Net_Table.getValues(net).second) {
+                fill(netWords.begin() + (size_t)net * blockWords, netWords.begin() + (size_t)(net + 1) * blockWords, ~0ULL);
+            }
+        }
+    }
+
+    /**
+     * @brief Evaluates all the gates once in level order on a block of patterns.
+     * Net n holds the words netWords[n * B] to netWords[n * B + B - 1], pattern k of the block
+     * is bit k % 64 of word k / 64.
+     */
+    void evalBlock(const GateBlockTable& t, const vector<GateBlockFn>& fns, uint64_t* netWords) {
+        const int B = t.blockWords;
+        for (size_t l = 0; l < levelOrder.size(); l++) {
+            const GateQueue::GateRecord& g = Gate_Queue.records[levelOrder[l]];
+            if (!g.numOutputs) {
+                continue;
+            }
+            const int* pins = Gate_Queue.getPins(g);
+            uint64_t* out = netWords + (size_t)pins[g.numInputs] * B;
+            fns[l](pins, g.numInputs, netWords, out);
+            for (int i = 1; i < g.numOutputs; i++) {
+                memcpy(netWords + (size_t)pins[g.numInputs + i] * B, out, B * sizeof(uint64_t));
+            }
+        }
+    }
+
+    /**
+     * @brief Levelizes the circuit and gets the kernels of the pattern parallel simulation, before
+     * any waveform is created.
+     *
+     * @param width The number of patterns per block, 0 for the widest the CPU supports
+     * @return 0 on success, 1 if the circuit is not combinational or a gate is not supported
+     */
+    int preparePatterns(int width) {
+        if (levelize()) {
+            return 1;
+        }
+        if (getGateBlockTable(width, blockTable)) {
+            cerr << "-E- Unsupported pattern width: " << width << " expected 64, 256 or 512" << endl;
+            return 1;
+        }
+        return getBlockFns(blockTable, blockFns);
+    }
+
+    /**
+     * @brief Simulates the entire combinational circuit a block of vectors at a time. Every net
+     * holds a block of 64, 256 or 512 patterns and the gates are evaluated once per block in
+     * level order. The settled values are written per vector, like the event driven simulation.
+     * Call preparePatterns first.
+     */
+    void SimulatePatterns() {
+        const GateBlockTable& t = blockTable;
+        const vector<GateBlockFn>& fns = blockFns;
+        const int B = t.blockWords;
+        cout << "-I- Simulating " << 64 * B << " patterns per block with the " << t.name << " kernels" << endl;
+
+        // nets not driven by a gate or an input keep their initial value in all patterns
+        vector<uint64_t> netWords;
+        initBlocks(B, netWords);
+
+        // the vectors of a vector file are copied a block at a time from its signal-major words
+        hcmSigVec* vecFile = stim.getVectorFile();
+        int firstVec = 0;
+        vector<uint64_t> words(stim.getWordsPerVector());
+        for (;;) {
+            // transpose the next block of vectors into the input net words
+            int numPatterns = 0;
+            for (size_t i = 0; i < inputBindings.size(); i++) {
+                fill(netWords.begin() + (size_t)inputBindings[i].second * B,
+                     netWords.begin() + (size_t)(inputBindings[i].second + 1) * B, 0);
+            }
+            if (vecFile) {
+                numPatterns = min(64 * B, vecFile->getNumVectors() - firstVec);
+                for (size_t i = 0; numPatterns > 0 && i < inputBindings.size(); i++) {
+                    const uint64_t* sigWords = vecFile->getSignalWords(inputBindings[i].first) + firstVec / 64;
+                    copy(sigWords, sigWords + (numPatterns + 63) / 64,
+                         netWords.begin() + (size_t)inputBindings[i].second * B);
+                }
+                firstVec += numPatterns;
+            }
+            else {
+                for (; numPatterns < 64 * B && stim.nextVector(words.data()) == 0; numPatterns++) {
+                    for (size_t i = 0; i < inputBindings.size(); i++) {
+                        int idx = inputBindings[i].first;
+                        netWords[(size_t)inputBindings[i].second * B + numPatterns / 64] |=
+                            ((words[idx / 64] >> (idx % 64)) & 1) << (numPatterns % 64);
+                    }
+                }
+            }
+            if (!numPatterns) {
+                break;
+            }
+
+            evalBlock(t, fns, netWords.data());
+
+            // unpack the outputs per vector
+            for (int k = 0; k < numPatterns; k++) {
+                for (size_t i = 0; i < dumpedNets.size(); i++) {
+                    vcd->changeValue(dumpedNets[i].second, (netWords[(size_t)dumpedNets[i].first * B + k / 64] >> (k % 64)) & 1);
+                }
+                vcd->changeTime(time++);
+            }
+        }
+    }
+
+    /**
+     * @brief Microbenchmark of the pattern parallel kernels. The same 512 vectors are evaluated
+     * with every kernel implementation available on this CPU, the values of all nets are checked
+     * bit exact against the 64 pattern kernels and the gate evaluations per second are reported.
+     * No values are written.
+     *
+     * @return 0 on success, 1 if the circuit is not combinational or an implementation mismatches
+     */
+    int BenchPatterns() {
+        if (levelize()) {
+            return 1;
+        }
+
+        // the kernel implementations by width, the first one is the reference
+        vector<GateBlockTable> tables;
+        GateBlockTable t;
+        GateBlockKernels<uint64_t>::fill(t, "scalar");
+        tables.push_back(t);
+        GateBlockKernels<GateWords<4> >::fill(t, "portable");
+        tables.push_back(t);
+        GateBlockKernels<GateWords<8> >::fill(t, "portable");
+        tables.push_back(t);
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            getAvx2BlockTable(t);
+            tables.push_back(t);
+        }
+        if (__builtin_cpu_supports("avx512f")) {
+            getAvx512BlockTable(t);
+            tables.push_back(t);
+        }
+#endif
+
+        // transpose 512 vectors into 8 words per input, missing vectors are all zero
+        const int maxWords = 8;
+        const int numPatterns = 64 * maxWords;
+        vector<uint64_t> inputWords(inputBindings.size() * maxWords, 0);
+        vector<uint64_t> words(stim.getWordsPerVector());
+        for (int k = 0; k < numPatterns && stim.nextVector(words.data()) == 0; k++) {
+            for (size_t i = 0; i < inputBindings.size(); i++) {
+                int idx = inputBindings[i].first;
+                inputWords[i * maxWords + k / 64] |= ((words[idx / 64] >> (idx % 64)) & 1) << (k % 64);
+            }
+        }
+
+        int numNets = Net_Table.getNumNets();
+        vector<uint64_t> ref;
+        int anyErr = 0;
+        for (size_t ti = 0; ti < tables.size(); ti++) {
+            const GateBlockTable& bt = tables[ti];
+            const int B = bt.blockWords;
+            vector<GateBlockFn> fns;
+            if (getBlockFns(bt, fns)) {
+                return 1;
+            }
+            vector<uint64_t> netWords;
+            initBlocks(B, netWords);
+
+            // one pass evaluates all the blocks of the 512 vectors, the first pass keeps all net values
+            vector<uint64_t> values((size_t)numNets * maxWords);
+            long passes = 0;
+            double secs = 0;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            do {
+                for (int b = 0; b < maxWords / B; b++) {
+                    for (size_t i = 0; i < inputBindings.size(); i++) {
+                        memcpy(&netWords[(size_t)inputBindings[i].second * B], &inputWords[i * maxWords + b * B], B * sizeof(uint64_t));
+                    }
+                    evalBlock(bt, fns, netWords.data());
+                    if (!passes) {
+                        for (int net = 0; net < numNets; net++) {
+                            memcpy(&values[(size_t)net * maxWords + b * B], &netWords[(size_t)net * B], B * sizeof(uint64_t));
+                        }
+                    }
+                }
+                passes++;
+                secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            } while (secs < 0.5);
+
+            bool exact = true;
+            if (ti == 0) {
+                ref.swap(values);
+            }
+            else if (values != ref) {
+                exact = false;
+                anyErr++;
+            }
+            printf("-I- %3d patterns %-8s %8.3g gate-evals/s (%ld passes of %d vectors)%s\n",
+                   64 * B, bt.name, (double)levelOrder.size() * numPatterns * passes / secs, passes, numPatterns,
+                   exact ? "" : " MISMATCH");
+        }
+        if (anyErr) {
+            cerr << "-E- " << anyErr << " kernel implementations are not bit exact with the 64 pattern kernels" << endl;
+            return 1;
+        }
+        return 0;
     }
 };
 
+/**
+ * @brief Replays vectors kept in memory, so several simulations can run on the same vectors.
+ */
+class StimReplay : public hcmStimulus {
+    const vector<uint64_t>& vectors;
+
+public:
+    StimReplay(int numSignals, const vector<uint64_t>& vectors) :
+        hcmStimulus(numSignals, vectors.size() / max(1, (numSignals + 63) / 64)), vectors(vectors) {}
+
+    virtual void generate(uint64_t* words) {
+        memcpy(words, &vectors[vecIdx * wordsPerVector], wordsPerVector * sizeof(uint64_t));
+    }
+};
+
+/**
+ * @brief Scaling benchmark of the parallel gate processor. The vectors of the stimulus are
+ * simulated once per number of threads from 1 to maxThreads, without writing values, and the
+ * settled values of every run are checked against the serial run.
+ *
+ * @return 0 on success, 1 if a run differs from the serial run
+ */
+int benchThreads(int maxThreads, hcmSigVec& parser, hcmStimulus& stim, hcmCell* flatCell, set<string>& globalNodes) {
+    vector<uint64_t> vectors;
+    vector<uint64_t> words(stim.getWordsPerVector());
+    while (stim.nextVector(words.data()) == 0) {
+        vectors.insert(vectors.end(), words.begin(), words.end());
+    }
+
+    uint64_t serialChecksum = 0;
+    double serialSecs = 0;
+    int anyErr = 0;
+    for (int threads = 1; threads <= maxThreads; threads++) {
+        StimReplay replay(stim.getNumSignals(), vectors);
+        EventDrivenSim sim(parser, replay, flatCell, globalNodes, 1);
+        if (sim.prepare()) {
+            return 1;
+        }
+        sim.setThreads(threads);
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        sim.Simulate();
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (threads == 1) {
+            serialChecksum = sim.getChecksum();
+            serialSecs = secs;
+        }
+        bool same = (sim.getChecksum() == serialChecksum);
+        anyErr += !same;
+        printf("-I- %2d threads %8.3f sec speedup %5.2f checksum %016llx%s\n", threads, secs, serialSecs / secs,
+               (unsigned long long)sim.getChecksum(), same ? "" : " MISMATCH");
+    }
+    if (anyErr) {
+        cerr << "-E- " << anyErr << " parallel runs differ from the serial run" << endl;
+        return 1;
+    }
+    return 0;
+}
+
 
 //globals:
 bool verbose = false;
@@ -552,27 +2080,123 @@ int main(int argc, char** argv) {
     int anyErr = 0;
     unsigned int i;
     vector<string> vlgFiles;
+    int cleanupPasses = CLEANUP_NONE;
+    bool binaryWave = false;
+    // the pattern parallel width, -1 for the event driven simulation and 0 for the widest supported
+    int patternWidth = -1;
+    bool patternBench = false;
+    // the vectors per run of the compiled code simulation, -1 for the event driven simulation
+    int compiledWidth = -1;
+    bool jit = false;
+    // the threads of the gate processor, and the most threads of the scaling benchmark
+    int numThreads = 1;
+    int benchMaxThreads = 0;
+    vcdDumpControl dumpControl;
+    string stimSpec;
+    vector<string> stimWeights;
 
     if (argc < 5) {
         anyErr++;
     }
     else {
-        if (!strcmp(argv[argIdx], "-v")) {
-            argIdx++;
-            verbose = true;
+        // the options come first in any order, the simulation modes exclude each other
+        int numModes = 0;
+        for (; argIdx < argc && argv[argIdx][0] == '-'; argIdx++) {
+            string opt = argv[argIdx];
+            if (opt == "-v") {
+                verbose = true;
+            }
+            else if (opt == "-b") {
+                binaryWave = true;
+            }
+            else if (opt == "-c" || opt == "-c64" || opt == "--jit") {
+                compiledWidth = (opt == "-c") ? 1 : 64;
+                jit = (opt == "--jit");
+                numModes++;
+            }
+            else if (opt == "-pbench") {
+                patternBench = true;
+                numModes++;
+            }
+            else if (opt == "-p" || opt == "-p64" || opt == "-p256" || opt == "-p512") {
+                patternWidth = atoi(opt.c_str() + 2);
+                numModes++;
+            }
+            else if (argIdx + 1 >= argc) {
+                cerr << "-E- Missing value of option: " << opt << endl;
+                anyErr++;
+            }
+            else if (opt == "-O") {
+                cleanupPasses = hcmParseCleanupPasses(argv[++argIdx]);
+                if (cleanupPasses < 0) {
+                    cerr << "-E- Unknown cleanup pass in: " << argv[argIdx] << endl;
+                    anyErr++;
+                }
+            }
+            else if (opt == "-threads" || opt == "-threads-bench") {
+                int n = atoi(argv[++argIdx]);
+                if (n < 1) {
+                    cerr << "-E- Bad number of threads: " << argv[argIdx] << endl;
+                    anyErr++;
+                }
+                if (opt == "-threads") {
+                    numThreads = n;
+                }
+                else {
+                    benchMaxThreads = n;
+                    numModes++;
+                }
+            }
+            else if (opt == "-stim") {
+                stimSpec = argv[++argIdx];
+            }
+            else if (opt == "-weight") {
+                stimWeights.push_back(argv[++argIdx]);
+            }
+            else if (opt == "-dump-sig") {
+                dumpControl.signalGlobs.push_back(argv[++argIdx]);
+            }
+            else if (opt == "-dump-scope") {
+                dumpControl.scopes.push_back(argv[++argIdx]);
+            }
+            else if (opt == "-dump-cone") {
+                dumpControl.coneOutputs.push_back(argv[++argIdx]);
+            }
+            else if (opt == "-dump-window") {
+                if (dumpControl.parseWindow(argv[++argIdx])) {
+                    cerr << "-E- Bad dump window: " << argv[argIdx] << " expected start:stop" << endl;
+                    anyErr++;
+                }
+            }
+            else {
+                cerr << "-E- Unknown option: " << opt << endl;
+                anyErr++;
+            }
+        }
+        if (numModes && numThreads > 1) {
+            cerr << "-E- -threads applies to the event driven simulation only" << endl;
+            anyErr++;
+        }
+        if (numModes > 1) {
+            cerr << "-E- Only one of -c, -c64, --jit, -p, -p64, -p256, -p512, -pbench and -threads-bench can be given" << endl;
+            anyErr++;
         }
         for (;argIdx < argc; argIdx++) {
             vlgFiles.push_back(argv[argIdx]);
         }
 
-        if (vlgFiles.size() < 2) {
+        if (vlgFiles.size() < (stimSpec.empty() ? 4 : 3)) {
             cerr << "-E- At least top-level and single verilog file required for spec model" << endl;
             anyErr++;
         }
     }
 
     if (anyErr) {
-        cerr << "Usage: " << argv[0] << "  [-v] top-cell signal_file.sig.txt vector_file.vec.txt file1.v [file2.v] ... \n";
+        cerr << "Usage: " << argv[0] << "  [-v] [-O const,buf,dead|all] [-b] [-c|-c64|--jit|-p|-p64|-p256|-p512|-pbench] [-dump-sig glob] [-dump-scope inst] [-dump-cone node] [-dump-window start:stop]\n"
+             << "       [-threads N] [-threads-bench N]\n"
+             << "       [-stim lfsr:N[:seed]|xoshiro:N[:seed]|exhaustive|weighted:N[:seed]] [-weight signal=prob] ...\n"
+             << "       top-cell signal_file.sig.txt [vector_file.vec.txt] file1.v [file2.v] ... \n"
+             << "  the options may come in any order, the vector file is given only when no -stim is used\n";
         exit(1);
     }
 
@@ -582,7 +2206,9 @@ int main(int argc, char** argv) {
 
     hcmDesign* design = new hcmDesign("design");
     string cellName = vlgFiles[0];
-    for (i = 3; i < vlgFiles.size(); i++) {
+    // with a stimulus generator there is no vector file
+    unsigned int firstVlg = stimSpec.empty() ? 3 : 2;
+    for (i = firstVlg; i < vlgFiles.size(); i++) {
         printf("-I- Parsing verilog %s ...\n", vlgFiles[i].c_str());
         if (!design->parseStructuralVerilog(vlgFiles[i].c_str())) {
             cerr << "-E- Could not parse: " << vlgFiles[i] << " aborting." << endl;
@@ -598,11 +2224,43 @@ int main(int argc, char** argv) {
 
     hcmCell* flatCell = hcmFlatten(cellName + string("_flat"), topCell, globalNodes);
     cout << "-I- Top cell flattened" << endl;
+    if (cleanupPasses) {
+        hcmCleanupCell(flatCell, globalNodes, cleanupPasses);
+    }
 
     string signalTextFile = vlgFiles[1];
-    string vectorTextFile = vlgFiles[2];
+    string vectorTextFile = stimSpec.empty() ? vlgFiles[2] : string("");
 
 
+    // initiate the time variable "time" to 1 
+    int time = 1;
+    hcmSigVec parser(signalTextFile, vectorTextFile, verbose);
+    if (!parser.good()) {
+        exit(1);
+    }
+    hcmStimulus* stim = hcmCreateStimulus(stimSpec, parser, stimWeights);
+    if (stim == NULL) {
+        exit(1);
+    }
+
+    // check the circuit can be simulated in the chosen mode before creating the waveform
+    EventDrivenSim sim(parser, *stim, flatCell, globalNodes, time);
+    if (sim.prepare()) {
+        exit(1);
+    }
+    // the benchmarks write no values so they have no waveform
+    if (patternBench || benchMaxThreads) {
+        int res = patternBench ? sim.BenchPatterns() : benchThreads(benchMaxThreads, parser, *stim, flatCell, globalNodes);
+        delete stim;
+        return(res);
+    }
+    if (patternWidth >= 0 && sim.preparePatterns(patternWidth)) {
+        exit(1);
+    }
+    if (compiledWidth > 0 && sim.prepareCompiled(compiledWidth, jit)) {
+        exit(1);
+    }
+
     // Genarate the vcd file
     //-----------------------------------------------------------------------------------------//
     // If you need to debug internal nodes, set debug_mode to true in order to see in 
@@ -611,23 +2269,28 @@ int main(int argc, char** argv) {
     // you need to submit your work with debug_mode = false
     // vcdFormatter vcd(cellName + ".vcd", flatCell, globalNodes, true);  <--- for debug only!
     //-----------------------------------------------------------------------------------------//
-    vcdFormatter vcd(cellName + ".vcd", flatCell, globalNodes);
+    vcdFormatter vcd(cellName + (binaryWave ? ".hwv" : ".vcd"), flatCell, globalNodes, false, binaryWave, &dumpControl);
     if (!vcd.good()) {
         printf("-E- vcd initialization error.\n");
         exit(1);
     }
-
-    // initiate the time variable "time" to 1 
-    int time = 1;
-    hcmSigVec parser(signalTextFile, vectorTextFile, verbose);
-    set<string> signals;
-    parser.getSignals(signals);
+    sim.setWaveform(&vcd);
 
     //-----------------------------------------------------------------------------------------//
 
-    EventDrivenSim sim(vcd, parser, flatCell, globalNodes, time);
-
-    sim.Simulate();
+    if (compiledWidth > 0) {
+        sim.SimulateCompiled(compiledWidth);
+    }
+    else if (patternWidth >= 0) {
+        sim.SimulatePatterns();
+    }
+    else {
+        sim.setThreads(numThreads);
+        sim.Simulate();
+    }
+    vcd.close();
+    vcd.printWriterStats(cout);
+    delete stim;
 
     return(0);
 
@@ -0,0 +1,205 @@
+#ifndef __GATEKERNELS_H__
+#define __GATEKERNELS_H__
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The gate kernels shared by the event driven simulation and the pattern parallel simulation.
+ * The kernels are templates on the word type W, every bit position of a word is an independent
+ * evaluation. The SIMD translation units (simd_avx2.cc, simd_avx512.cc) are compiled with their
+ * own target flags so they must only instantiate the kernels with their own word type, and every
+ * non template function here is static so no copy built for a wider target is shared.
+ */
+
+/**
+ * @brief The logic function of a primitive gate.
+ */
+typedef enum {
+    BUFFER, NOT, DFF,
+    OR, NOR, AND, NAND, XOR,
+    UNSUPPORTED
+} GateOp;
+
+// the largest number of inputs the gate kernels are specialized for
+const int MAX_KERNEL_INPUTS = 9;
+
+/**
+ * @brief Reduces N input words with and/or/xor, unrolled at compile time.
+ */
+template<int N, typename W = uint64_t>
+struct GateReduce {
+    static W andOf(const W* in) { return GateReduce<N - 1, W>::andOf(in) & in[N - 1]; }
+    static W orOf(const W* in)  { return GateReduce<N - 1, W>::orOf(in) | in[N - 1]; }
+    static W xorOf(const W* in) { return GateReduce<N - 1, W>::xorOf(in) ^ in[N - 1]; }
+};
+
+template<typename W>
+struct GateReduce<1, W> {
+    static W andOf(const W* in) { return in[0]; }
+    static W orOf(const W* in)  { return in[0]; }
+    static W xorOf(const W* in) { return in[0]; }
+};
+
+/**
+ * @brief The kernel of a combinational gate of N inputs. It works on 1-bit scalar values in bit 0,
+ * on 64 pattern words and on wider SIMD words alike.
+ * Op is a compile time constant so the switch folds to the few bitwise instructions of the gate.
+ */
+template<GateOp Op, int N, typename W = uint64_t>
+inline W gateKernel(const W* in) {
+    switch (Op) {
+        case BUFFER: return in[0];
+        case NOT:    return ~in[0];
+        case OR:     return GateReduce<N, W>::orOf(in);
+        case NOR:    return ~GateReduce<N, W>::orOf(in);
+        case AND:    return GateReduce<N, W>::andOf(in);
+        case NAND:   return ~GateReduce<N, W>::andOf(in);
+        case XOR:    return GateReduce<N, W>::xorOf(in);
+        default:     return in[0] ^ in[0];
+    }
+}
+
+/**
+ * @brief The kernel of a DFF: samples the old D value when the clock is high, otherwise holds Q.
+ */
+template<typename W>
+inline W dffKernel(W clk, W oldD, W q) {
+    return (clk & oldD) | (~clk & q);
+}
+
+/**
+ * @brief Gets the column of a kernel table of a gate by its function and number of inputs.
+ * Column 0 is unsupported, columns 1 to MAX_KERNEL_INPUTS are the specialized kernels and
+ * the last column the kernels of wider gates.
+ */
+static inline int getKernelColumn(GateOp op, int numInputs) {
+    switch (op) {
+        case DFF:
+            return numInputs >= 2 ? 2 : 0;
+        case BUFFER:
+        case NOT:
+            // only the first input drives a buffer or an inverter
+            return numInputs >= 1 ? 1 : 0;
+        default:
+            return numInputs > MAX_KERNEL_INPUTS ? MAX_KERNEL_INPUTS + 1 : numInputs;
+    }
+}
+
+/**
+ * GateWords - a block of B pattern words evaluated word by word, the portable form of the
+ * wide kernels.
+ */
+template<int B>
+struct GateWords {
+    uint64_t w[B];
+
+    GateWords operator&(const GateWords& o) const { GateWords r; for (int i = 0; i < B; i++) r.w[i] = w[i] & o.w[i]; return r; }
+    GateWords operator|(const GateWords& o) const { GateWords r; for (int i = 0; i < B; i++) r.w[i] = w[i] | o.w[i]; return r; }
+    GateWords operator^(const GateWords& o) const { GateWords r; for (int i = 0; i < B; i++) r.w[i] = w[i] ^ o.w[i]; return r; }
+    GateWords operator~() const { GateWords r; for (int i = 0; i < B; i++) r.w[i] = ~w[i]; return r; }
+};
+
+/**
+ * @brief Evaluates a combinational gate on a block of patterns. Net n holds the block words
+ * netWords[n * B] to netWords[n * B + B - 1], the result is written to out.
+ */
+typedef void (*GateBlockFn)(const int* pins, int numInputs, const uint64_t* netWords, uint64_t* out);
+
+/**
+ * GateBlockTable - the block kernels of one width by gate function and kernel column,
+ * NULL where the gate has no pattern parallel kernel (i.e. the DFF).
+ */
+struct GateBlockTable {
+    // the number of 64 bit words in a block and the name of the implementation
+    int         blockWords;
+    const char* name;
+    GateBlockFn fn[UNSUPPORTED][MAX_KERNEL_INPUTS + 2];
+};
+
+/**
+ * GateBlockKernels - the block kernels on the word type V, a block is sizeof(V) bytes.
+ */
+template<typename V>
+struct GateBlockKernels {
+    static const int B = sizeof(V) / sizeof(uint64_t);
+
+    static V load(const uint64_t* netWords, int net) {
+        V v;
+        memcpy(&v, netWords + (size_t)net * B, sizeof(V));
+        return v;
+    }
+
+    template<GateOp Op, int N>
+    static void eval(const int* pins, int, const uint64_t* netWords, uint64_t* out) {
+        V in[N];
+        for (int i = 0; i < N; i++) {
+            in[i] = load(netWords, pins[i]);
+        }
+        V res = gateKernel<Op, N, V>(in);
+        memcpy(out, &res, sizeof(V));
+    }
+
+    template<GateOp Op>
+    static void evalWide(const int* pins, int numInputs, const uint64_t* netWords, uint64_t* out) {
+        V acc = load(netWords, pins[0]);
+        for (int i = 1; i < numInputs; i++) {
+            V v = load(netWords, pins[i]);
+            acc = (Op == AND || Op == NAND) ? (acc & v) : (Op == XOR) ? (acc ^ v) : (acc | v);
+        }
+        if (Op == NAND || Op == NOR) {
+            acc = ~acc;
+        }
+        memcpy(out, &acc, sizeof(V));
+    }
+
+    /**
+     * @brief Fills columns 1 to N of the row of Op.
+     */
+    template<GateOp Op, int N>
+    struct Row {
+        static void fill(GateBlockTable& t) {
+            t.fn[Op][N] = &eval<Op, N>;
+            Row<Op, N - 1>::fill(t);
+        }
+    };
+
+    template<GateOp Op>
+    struct Row<Op, 0> {
+        static void fill(GateBlockTable&) {}
+    };
+
+    template<GateOp Op>
+    static void fillWideRow(GateBlockTable& t) {
+        Row<Op, MAX_KERNEL_INPUTS>::fill(t);
+        t.fn[Op][MAX_KERNEL_INPUTS + 1] = &evalWide<Op>;
+    }
+
+    static void fill(GateBlockTable& t, const char* name) {
+        t.blockWords = B;
+        t.name = name;
+        for (int op = 0; op < UNSUPPORTED; op++) {
+            for (int n = 0; n < MAX_KERNEL_INPUTS + 2; n++) {
+                t.fn[op][n] = NULL;
+            }
+        }
+        Row<BUFFER, 1>::fill(t);
+        Row<NOT, 1>::fill(t);
+        fillWideRow<OR>(t);
+        fillWideRow<NOR>(t);
+        fillWideRow<AND>(t);
+        fillWideRow<NAND>(t);
+        fillWideRow<XOR>(t);
+    }
+};
+
+/** @fn void getAvx2BlockTable(GateBlockTable& t)
+ * @brief fill the table with the AVX2 kernels, 256 patterns per block. Call only if the CPU supports AVX2.
+ */
+void getAvx2BlockTable(GateBlockTable& t);
+
+/** @fn void getAvx512BlockTable(GateBlockTable& t)
+ * @brief fill the table with the AVX-512 kernels, 512 patterns per block. Call only if the CPU supports AVX-512F.
+ */
+void getAvx512BlockTable(GateBlockTable& t);
+
+#endif //__GATEKERNELS_H__
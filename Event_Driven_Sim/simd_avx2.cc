@@ -0,0 +1,8 @@
+#include "gatekernels.h"
+
+// compiled with -mavx2, the generic vector operations on 256 bit words become AVX2 instructions
+typedef uint64_t GateAvx2Word __attribute__((vector_size(32)));
+
+void getAvx2BlockTable(GateBlockTable& t) {
+    GateBlockKernels<GateAvx2Word>::fill(t, "avx2");
+}
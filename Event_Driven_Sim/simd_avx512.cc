@@ -0,0 +1,8 @@
+#include "gatekernels.h"
+
+// compiled with -mavx512f, the generic vector operations on 512 bit words become AVX-512 instructions
+typedef uint64_t GateAvx512Word __attribute__((vector_size(64)));
+
+void getAvx512BlockTable(GateBlockTable& t) {
+    GateBlockKernels<GateAvx512Word>::fill(t, "avx512");
+}
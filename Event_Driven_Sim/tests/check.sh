@@ -0,0 +1,85 @@
+#!/bin/bash
+# Runs every simulation engine on the test circuits and compares the VCD files with the golden
+# ones in tests/ using vcddiff. Also checks that the circuits and option combinations an engine
+# does not support are rejected without leaving a waveform behind.
+# Usage: tests/check.sh (run by make check), exits with 1 if any check fails.
+
+SIMDIR=$(cd "$(dirname "$0")/.." && pwd)
+TESTS=$SIMDIR/tests
+SIM=$SIMDIR/event_sim
+VCDDIFF=$SIMDIR/../vcd/vcddiff
+WORK=$(mktemp -d) || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+numChecks=0
+numFails=0
+
+# check expect lib circuit top [options...]
+#   same   - the run succeeds and its VCD matches tests/<top>.vcd
+#   reject - the run exits with 1 and creates no VCD
+#   nowave - the run succeeds and creates no VCD
+check() {
+  local expect=$1 lib=$2 circuit=$3 top=$4
+  shift 4
+  rm -f "$WORK"/*.vcd "$WORK/diff.log"
+  (cd "$WORK" && "$SIM" "$@" $top $TESTS/$circuit.sig.txt $TESTS/$circuit.vec.txt \
+                  $SIMDIR/$lib $TESTS/$circuit.v > run.log 2>&1)
+  local rc=$? ok=0
+  case $expect in
+    same)   [ $rc -eq 0 ] && "$VCDDIFF" $TESTS/$top.vcd "$WORK/$top.vcd" > "$WORK/diff.log" 2>&1 && ok=1 ;;
+    reject) [ $rc -eq 1 ] && [ ! -e "$WORK/$top.vcd" ] && ok=1 ;;
+    nowave) [ $rc -eq 0 ] && [ ! -e "$WORK/$top.vcd" ] && ok=1 ;;
+  esac
+  numChecks=$((numChecks + 1))
+  if [ $ok -eq 1 ]; then
+    echo "-I- PASS $expect: $* $top ($lib)"
+  else
+    numFails=$((numFails + 1))
+    echo "-E- FAIL $expect: $* $top ($lib), exit code $rc"
+    cat "$WORK/run.log" "$WORK/diff.log" 2>/dev/null | grep -- '^-[EW]-' | head -5
+  fi
+}
+
+if [ ! -x "$SIM" ] || [ ! -x "$VCDDIFF" ]; then
+  echo "-E- Build event_sim and ../vcd/vcddiff first"
+  exit 1
+fi
+
+# a combinational circuit runs on every engine
+for mode in "" -c -c64 -p -p64 -p256 -p512 --jit "-threads 4"; do
+  check same stdcell.v c3540 TopLevel3540 $mode
+done
+check same stdcell_FF.v c3540 TopLevel3540
+
+# sequential circuits run on the event driven and the one vector compiled simulation only
+for t in "c2806 TopLevel2806" "shiftReg shiftReg" "shiftRegDifCLK shiftRegDifCLK"; do
+  set -- $t
+  for mode in "" -c "-threads 4"; do
+    check same stdcell.v $1 $2 $mode
+  done
+  for mode in -c64 -p64 --jit; do
+    check reject stdcell.v $1 $2 $mode
+  done
+  # the latches of the gate level DFFs are combinational loops
+  for mode in "" "-threads 4"; do
+    check same stdcell_FF.v $1 $2 $mode
+  done
+  check reject stdcell_FF.v $1 $2 -c
+done
+
+# a clock driven by logic may glitch within a vector, only the event driven simulation sees that
+check reject stdcell.v gatedClk gatedClk -c
+
+# the options may come in any order but only one mode is allowed
+check same stdcell.v c3540 TopLevel3540 -threads 2 -O all
+check reject stdcell.v c3540 TopLevel3540 -c -p64
+check reject stdcell.v c3540 TopLevel3540 -threads 4 -c
+check reject stdcell.v c3540 TopLevel3540 -p -threads 4
+check reject stdcell.v c3540 TopLevel3540 -unknown
+
+# the benchmarks create no waveform
+check nowave stdcell.v c3540 TopLevel3540 -pbench
+check nowave stdcell.v c3540 TopLevel3540 -threads-bench 2
+
+echo "-I- $((numChecks - numFails)) of $numChecks checks passed"
+[ $numFails -eq 0 ]
@@ -0,0 +1,10 @@
+module gatedClk(I, C1, EN, S);
+   input  I;
+   input  C1;
+   input  EN;
+   output S;
+   wire   G;
+
+   and2 g1( .A(C1), .B(EN), .Y(G) );
+   dff ff1( .CLK(G), .D(I), .Q(S) );
+endmodule
@@ -9,6 +9,8 @@
 #include <vector>
 #include "hcm.h"
 #include "flat.h"
+#include "cleanup.h"
+#include "aig.h"
 #include "utils/System.h"
 #include "utils/ParseUtils.h"
 #include "utils/Options.h"
@@ -947,6 +949,223 @@ void FEC::writeToCNF() {
 }
 
 
+/**
+ * @brief SAT-based Gate Level Formal Equivalence Checker on a structurally hashed AIG.
+ * The spec and imp circuits are added to one AIG sharing inputs and flip-flop outputs by name,
+ * so logic identical in both circuits collapses into the same nodes and only the differing
+ * part of the miter reaches the solver.
+ */
+class AigFEC {
+    Solver*      solver;
+    string       fileName;
+    hcmAig       aig;
+    hcmAigLit    miter;
+    int          numImpInputs;
+
+public:
+    AigFEC() = delete;
+
+    /**
+     * @brief Construct a new AigFEC object.
+     * 
+     * @param solver SAT solver
+     * @param fileName Name of the CNF file
+     * @param specCell Specification cell
+     * @param impCell Implementation cell
+     * @param globalNodes Set of global nodes
+     */
+    AigFEC(Solver* solver, string fileName, hcmCell* specCell, hcmCell* impCell, set<string>& globalNodes);
+
+    /**
+     * @brief Destroy the AigFEC object.
+     */
+    ~AigFEC() {}
+
+    /**
+     * @brief Build the miter of the paired outputs and flip-flop inputs.
+     */
+    void calcMiter();
+
+    /**
+     * @brief Calculate the Tseitin transformation of the and nodes in the cone of the miter.
+     */
+    void calcTseitin();
+
+    /**
+     * @brief Print the input assignments.
+     */
+    void printInputAssign();
+
+    /**
+     * @brief Handle error messages.
+     * 
+     * @param msg Error message
+     */
+    void error(string msg);
+
+    /**
+     * @brief Get the solver literal of an AIG literal.
+     */
+    Lit aigToLit(hcmAigLit lit) { return mkLit(aigNode(lit), aigIsCompl(lit)); }
+};
+
+AigFEC::AigFEC(Solver* solver, string fileName, hcmCell* specCell, hcmCell* impCell, set<string>& globalNodes) :
+    solver(solver), fileName(fileName), miter(AIG_FALSE) {
+
+    if (hcmAddCellToAig(&aig, specCell, globalNodes, "spec/")) {
+        error("Could not convert the spec circuit to AIG!");
+    }
+    int numSpecInputs = aig.getNumInputs();
+    int numSpecLatches = aig.getNumLatches();
+    if (hcmAddCellToAig(&aig, impCell, globalNodes, "imp/")) {
+        error("Could not convert the imp circuit to AIG!");
+    }
+    numImpInputs = aig.getNumInputs() - numSpecInputs;
+
+    // the flip-flops of the imp circuit must reuse the inputs of the spec ones
+    set<int> specFFs, impFFs;
+    for (int l = 0; l < aig.getNumLatches(); l++) {
+        (l < numSpecLatches ? specFFs : impFFs).insert(aig.getLatchInput(l));
+    }
+    if (specFFs != impFFs) {
+        error("The FFs in the spec and imp circuits are different!");
+    }
+
+    bool anyCommonPI = false;
+    for (auto it : impCell->getNodes()) {
+        hcmPort* port = it.second->getPort();
+        if (port != nullptr && port->getDirection() == IN) {
+            int input = aig.findInput(it.first);
+            anyCommonPI |= (input >= 0 && input < numSpecInputs);
+        }
+    }
+    if (!anyCommonPI) {
+        error("The inputs of the spec and imp circuits are completely different!");
+    }
+
+    calcMiter();
+    aig.printStats(cout);
+
+    calcTseitin();
+
+    vec<Lit> tmp;
+    solver->toDimacs(fileName.c_str(), tmp);
+}
+
+void AigFEC::error(string msg) {
+    cout << endl;
+    cout << "Error: " << msg << endl;
+    cout << "The Circuits Are Not Equivalent!" << endl;
+    cout << endl;
+    cout << "SATISFIABLE!" << endl;
+    exit(1);
+}
+
+void AigFEC::calcMiter() {
+    map<string, hcmAigLit> specOutputs, impOutputs;
+    string specPrefix = "spec/", impPrefix = "imp/";
+
+    for (int o = 0; o < aig.getNumOutputs(); o++) {
+        string name = aig.getOutputName(o);
+        if (name.compare(0, specPrefix.size(), specPrefix) == 0) {
+            specOutputs[name.substr(specPrefix.size())] = aig.getOutputLit(o);
+        }
+        else {
+            impOutputs[name.substr(impPrefix.size())] = aig.getOutputLit(o);
+        }
+    }
+    if (specOutputs.size() != impOutputs.size()) {
+        error("The outputs of the spec and imp circuits are different!");
+    }
+
+    vector<hcmAigLit> diffs;
+    for (auto it : specOutputs) {
+        map<string, hcmAigLit>::iterator impIt = impOutputs.find(it.first);
+        if (impIt == impOutputs.end()) {
+            error("The outputs of the spec and imp circuits are different!");
+        }
+        diffs.push_back(aigNot(aig.createXor(it.second, impIt->second)));
+    }
+    miter = aigNot(aig.createAnd(diffs));
+    aig.addOutput("FEC_PO", miter);
+}
+
+void AigFEC::calcTseitin() {
+    vec<Lit> lits;
+
+    for (int n = 0; n < aig.getNumNodes(); n++) {
+        solver->newVar();
+    }
+
+    // only the cone of the miter is encoded
+    vector<bool> inCone(aig.getNumNodes(), false);
+    inCone[aigNode(miter)] = true;
+    for (int n = aig.getNumNodes() - 1; n > 0; n--) {
+        if (!inCone[n] || !aig.isAnd(n)) {
+            continue;
+        }
+        inCone[aigNode(aig.getFanin0(n))] = true;
+        inCone[aigNode(aig.getFanin1(n))] = true;
+
+        Lit out = mkLit(n);
+        Lit in0 = aigToLit(aig.getFanin0(n));
+        Lit in1 = aigToLit(aig.getFanin1(n));
+
+        lits.clear();
+        lits.push(~out);
+        lits.push(in0);
+        solver->addClause(lits);
+
+        lits.clear();
+        lits.push(~out);
+        lits.push(in1);
+        solver->addClause(lits);
+
+        lits.clear();
+        lits.push(out);
+        lits.push(~in0);
+        lits.push(~in1);
+        solver->addClause(lits);
+    }
+
+    // node 0 is the constant 0, a miter folded to it makes the problem unsatisfiable
+    lits.clear();
+    lits.push(~mkLit(0));
+    solver->addClause(lits);
+
+    lits.clear();
+    lits.push(aigToLit(miter));
+    solver->addClause(lits);
+}
+
+void AigFEC::printInputAssign() {
+    vec<Lit> dummy;
+    lbool ret = solver->solveLimited(dummy);
+
+    if (ret == l_True) {
+        set<int> latchInputs;
+        for (int l = 0; l < aig.getNumLatches(); l++) {
+            latchInputs.insert(aig.getLatchInput(l));
+        }
+        cout << endl;
+        cout << "The Circuits Are Not Equivalent!" << endl; 
+        cout << "Input Assignment Vector Example: " << endl;
+        for (int i = 0; i < aig.getNumInputs(); i++) {
+            if (latchInputs.find(i) != latchInputs.end()) {
+                continue;
+            }
+            int solverVar = aig.getInputNode(i);
+            if (solver->model[solverVar] != l_Undef) {
+                string assign = solver->model[solverVar]==l_True ? "1" : "0";
+                cout << "Node name: " << aig.getInputName(i) << ", Solver value: " << solverVar+1 << ", Assignment: " << assign << endl;
+            }
+        }
+        cout << "All Other Inputs Are Set To 0" << endl;
+        cout << endl;
+    }
+}
+
+
 //globals:
 bool verbose = false;
 
@@ -959,29 +1178,40 @@ int main(int argc, char** argv) {
     vector<string> implementationVlgFiles;
     string specCellName;
     string implementationCellName;
+    int cleanupPasses = CLEANUP_NONE;
+    bool useAig = false;
     Solver solver;
 
-    if (argc < 8) {
-        anyErr++;
-    }
-    else {
+    // the options and the two models may come in any order, a model takes the arguments up to the next option
+    for (; argIdx < argc && !anyErr; argIdx++) {
         if (!strcmp(argv[argIdx], "-v")) {
-            argIdx++;
             verbose = true;
         }
-        if (!strcmp(argv[argIdx], "-s")) {
-            argIdx++;
-            specCellName = argv[argIdx++];
-            while (strcmp(argv[argIdx], "-i")) {
-                specVlgFiles.push_back(argv[argIdx++]);
+        else if (!strcmp(argv[argIdx], "-aig")) {
+            useAig = true;
+        }
+        else if (!strcmp(argv[argIdx], "-O") && argIdx + 1 < argc) {
+            cleanupPasses = hcmParseCleanupPasses(argv[++argIdx]);
+            if (cleanupPasses < 0) {
+                cerr << "-E- Unknown cleanup pass in: " << argv[argIdx] << endl;
+                anyErr++;
+            }
+        }
+        else if ((!strcmp(argv[argIdx], "-s") || !strcmp(argv[argIdx], "-i")) && argIdx + 1 < argc) {
+            bool spec = argv[argIdx][1] == 's';
+            (spec ? specCellName : implementationCellName) = argv[++argIdx];
+            vector<string>& files = spec ? specVlgFiles : implementationVlgFiles;
+            while (argIdx + 1 < argc && argv[argIdx + 1][0] != '-') {
+                files.push_back(argv[++argIdx]);
             }
         }
-        argIdx++;
-        implementationCellName = argv[argIdx++];
-        for (;argIdx < argc; argIdx++) {
-            implementationVlgFiles.push_back(argv[argIdx]);
+        else {
+            cerr << "-E- Unknown or incomplete option: " << argv[argIdx] << endl;
+            anyErr++;
         }
+    }
 
+    if (!anyErr) {
         if (implementationVlgFiles.size() < 2 || specVlgFiles.size() < 2) {
             cerr << "-E- At least top-level and single verilog file required for spec model" << endl;
             anyErr++;
@@ -989,7 +1219,8 @@ int main(int argc, char** argv) {
     }
 
     if (anyErr) {
-        cerr << "Usage: " << argv[0] << "  [-v] -s top-cell spec_file1.v spec_file2.v -i top-cell impl_file1.v impl_file2.v ... \n";
+        cerr << "Usage: " << argv[0] << "  [-v] [-O const,buf,dead|all] [-aig] -s top-cell spec_file1.v spec_file2.v -i top-cell impl_file1.v impl_file2.v ... \n";
+        cerr << "  the options may come in any order\n";
         exit(1);
     }
 
@@ -1034,8 +1265,26 @@ int main(int argc, char** argv) {
 
     hcmCell* flatImpCell = hcmFlatten(implementationCellName + string("_flat"), topImpCell, globalNodes);
 
+    if (cleanupPasses) {
+        hcmCleanupCell(flatSpecCell, globalNodes, cleanupPasses);
+        hcmCleanupCell(flatImpCell, globalNodes, cleanupPasses);
+    }
+
     //---------------------------------------------------------------------------------//
 
+    if (useAig) {
+        AigFEC fec(&solver, fileName, flatSpecCell, flatImpCell, globalNodes);
+        bool sat = solver.solve();
+        if (sat) {
+            fec.printInputAssign();
+            cout << "SATISFIABLE!" << endl;
+        }
+        else {
+            cout << "NOT SATISFIABLE!" << endl;
+        }
+        return 0;
+    }
+
     FEC fec(&solver, fileName, flatSpecCell, flatImpCell, globalNodes);
 
     //---------------------------------------------------------------------------------//
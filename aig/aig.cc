@@ -0,0 +1,387 @@
+#include "aig.h"
+#include "gates.h"
+#include <sstream>
+
+using namespace std;
+
+hcmAig::hcmAig() : numStrashHits(0) {
+  // node 0 is the constant
+  fanin0.push_back(0);
+  fanin1.push_back(0);
+  level.push_back(0);
+}
+
+hcmAigLit hcmAig::getInput(string name) {
+  map<string, hcmAigLit>::const_iterator iI = inputByName.find(name);
+  if (iI != inputByName.end()) {
+    return((*iI).second);
+  }
+  unsigned int node = fanin0.size();
+  fanin0.push_back(0);
+  fanin1.push_back(0);
+  level.push_back(0);
+  inputNodes.push_back(node);
+  inputNames.push_back(name);
+  inputByName[name] = 2 * node;
+  return(2 * node);
+}
+
+int hcmAig::findInput(string name) const {
+  map<string, hcmAigLit>::const_iterator iI = inputByName.find(name);
+  if (iI == inputByName.end()) {
+    return(-1);
+  }
+  for (size_t i = 0; i < inputNodes.size(); i++) {
+    if (inputNodes[i] == aigNode((*iI).second)) {
+      return(i);
+    }
+  }
+  return(-1);
+}
+
+hcmAigLit hcmAig::createAnd(hcmAigLit a, hcmAigLit b) {
+  if (a > b) {
+    hcmAigLit t = a;
+    a = b;
+    b = t;
+  }
+  if (a == AIG_FALSE || a == aigNot(b)) {
+    return(AIG_FALSE);
+  }
+  if (a == AIG_TRUE || a == b) {
+    return(b);
+  }
+
+  uint64_t key = ((uint64_t)a << 32) | b;
+  unordered_map<uint64_t, unsigned int>::const_iterator sI = strash.find(key);
+  if (sI != strash.end()) {
+    numStrashHits++;
+    return(2 * (*sI).second);
+  }
+  unsigned int node = fanin0.size();
+  fanin0.push_back(a);
+  fanin1.push_back(b);
+  level.push_back(1 + max(level[aigNode(a)], level[aigNode(b)]));
+  strash[key] = node;
+  return(2 * node);
+}
+
+hcmAigLit hcmAig::createXor(hcmAigLit a, hcmAigLit b) {
+  return(createOr(createAnd(a, aigNot(b)), createAnd(aigNot(a), b)));
+}
+
+hcmAigLit hcmAig::createAnd(const vector<hcmAigLit>& lits) {
+  if (lits.empty()) {
+    return(AIG_TRUE);
+  }
+  // and the pairs of every level until one literal is left
+  vector<hcmAigLit> level(lits);
+  while (level.size() > 1) {
+    vector<hcmAigLit> next;
+    for (size_t i = 0; i + 1 < level.size(); i += 2) {
+      next.push_back(createAnd(level[i], level[i + 1]));
+    }
+    if (level.size() & 1) {
+      next.push_back(level.back());
+    }
+    level.swap(next);
+  }
+  return(level[0]);
+}
+
+int hcmAig::addOutput(string name, hcmAigLit lit) {
+  outputLits.push_back(lit);
+  outputNames.push_back(name);
+  return(outputLits.size() - 1);
+}
+
+hcmAigLit hcmAig::addLatch(string name) {
+  hcmAigLit lit = getInput(name);
+  latchInput.push_back(findInput(name));
+  latchNext.push_back(AIG_FALSE);
+  latchClk.push_back(AIG_FALSE);
+  return(lit);
+}
+
+void hcmAig::setLatchNext(int latch, hcmAigLit next, hcmAigLit clk) {
+  latchNext[latch] = next;
+  latchClk[latch] = clk;
+}
+
+int hcmAig::getDepth() const {
+  int depth = 0;
+  for (size_t o = 0; o < outputLits.size(); o++) {
+    depth = max(depth, level[aigNode(outputLits[o])]);
+  }
+  for (size_t l = 0; l < latchNext.size(); l++) {
+    depth = max(depth, level[aigNode(latchNext[l])]);
+  }
+  return(depth);
+}
+
+void hcmAig::simulate(const vector<uint64_t>& inputWords, vector<uint64_t>& nodeWords) const {
+  nodeWords.resize(fanin0.size());
+  nodeWords[0] = 0;
+  for (size_t i = 0; i < inputNodes.size(); i++) {
+    nodeWords[inputNodes[i]] = inputWords[i];
+  }
+  for (size_t n = 1; n < fanin0.size(); n++) {
+    if (fanin0[n] == 0 && fanin1[n] == 0) {
+      continue;
+    }
+    nodeWords[n] = getLitWord(nodeWords, fanin0[n]) & getLitWord(nodeWords, fanin1[n]);
+  }
+}
+
+void hcmAig::printStats(ostream& out) const {
+  out << "-I- AIG: " << getNumInputs() - getNumLatches() << " inputs, " << getNumOutputs()
+      << " outputs, " << getNumLatches() << " dffs, " << getNumAnds() << " and nodes ("
+      << getNumStrashHits() << " shared), depth " << getDepth() << endl;
+}
+
+// --------------------- static functions ---------------------
+/**
+ * aigBuilder - the state of converting one flat cell, the literal of each node
+ * is computed on demand from its driver.
+ */
+class aigBuilder {
+  public:
+    hcmAig* aig;
+    set<string>& globalNodes;
+    map<const hcmNode*, hcmAigLit> nodeLits;
+    // nodes whose literal is being computed, reaching one again is a combinational loop
+    set<const hcmNode*> inProgress;
+    bool anyErr;
+
+    aigBuilder(hcmAig* aig, set<string>& globalNodes) : aig(aig), globalNodes(globalNodes), anyErr(false) {};
+    hcmAigLit getNodeLit(const hcmNode* node);
+    hcmAigLit getGateLit(const hcmInstance* inst);
+};
+
+hcmAigLit aigBuilder::getNodeLit(const hcmNode* node) {
+  map<const hcmNode*, hcmAigLit>::const_iterator lI = nodeLits.find(node);
+  if (lI != nodeLits.end()) {
+    return((*lI).second);
+  }
+  if (globalNodes.find(node->getName()) != globalNodes.end()) {
+    if (node->getName() == "VDD") {
+      return(nodeLits[node] = AIG_TRUE);
+    }
+    if (node->getName() == "VSS") {
+      return(nodeLits[node] = AIG_FALSE);
+    }
+    return(nodeLits[node] = aig->getInput(node->getName()));
+  }
+
+  const hcmInstance* driver = NULL;
+  map<string, hcmInstPort*>::const_iterator ipI;
+  for (ipI = node->getInstPorts().begin(); ipI != node->getInstPorts().end(); ipI++) {
+    if ((*ipI).second->getPort()->getDirection() == OUT) {
+      driver = (*ipI).second->getInst();
+    }
+  }
+  if (!driver) {
+    // a primary input or an undriven net
+    return(nodeLits[node] = aig->getInput(node->getName()));
+  }
+  if (!inProgress.insert(node).second) {
+    cerr << "-E- Combinational loop through node: " << node->getName() << endl;
+    anyErr = true;
+    return(AIG_FALSE);
+  }
+  hcmAigLit lit = getGateLit(driver);
+  inProgress.erase(node);
+  return(nodeLits[node] = lit);
+}
+
+hcmAigLit aigBuilder::getGateLit(const hcmInstance* inst) {
+  vector<hcmAigLit> ins;
+  map<string, hcmInstPort*>::const_iterator ipI;
+  for (ipI = inst->getInstPorts().begin(); ipI != inst->getInstPorts().end(); ipI++) {
+    if ((*ipI).second->getPort()->getDirection() == IN) {
+      ins.push_back(getNodeLit((*ipI).second->getNode()));
+    }
+  }
+
+  hcmGateType type = hcmGetGateType(inst->masterCell()->getName());
+  switch (type) {
+  case GATE_BUFFER:
+    return(ins[0]);
+  case GATE_NOT:
+    return(aigNot(ins[0]));
+  case GATE_AND:
+    return(aig->createAnd(ins));
+  case GATE_NAND:
+    return(aigNot(aig->createAnd(ins)));
+  case GATE_OR:
+  case GATE_NOR:
+    for (size_t i = 0; i < ins.size(); i++) {
+      ins[i] = aigNot(ins[i]);
+    }
+    return(type == GATE_OR ? aigNot(aig->createAnd(ins)) : aig->createAnd(ins));
+  case GATE_XOR:
+    return(aig->createXor(ins[0], ins[1]));
+  default:
+    cerr << "-E- Cell: " << inst->masterCell()->getName() << " of instance: " << inst->getName()
+         << " can not be converted to AIG" << endl;
+    anyErr = true;
+    return(AIG_FALSE);
+  }
+}
+
+/** @fn static hcmNode* getLitNode(hcmCell* cell, vector<hcmNode*>& nodes, vector<hcmNode*>& complNodes, hcmCell* inv, hcmAigLit lit)
+ * @brief gets the node carrying the literal, adding an inverter for complemented literals on first use.
+ */
+static hcmNode* getLitNode(hcmCell* cell, vector<hcmNode*>& nodes, vector<hcmNode*>& complNodes,
+                           hcmCell* inv, hcmAigLit lit) {
+  if (lit == AIG_FALSE) {
+    return(cell->getNode("VSS"));
+  }
+  if (lit == AIG_TRUE) {
+    return(cell->getNode("VDD"));
+  }
+  unsigned int node = aigNode(lit);
+  if (!aigIsCompl(lit)) {
+    return(nodes[node]);
+  }
+  if (!complNodes[node]) {
+    ostringstream name;
+    name << "aig_n" << node << "_n";
+    complNodes[node] = cell->createNode(name.str());
+    hcmInstance* inst = cell->createInst(string("inv_") + name.str(), inv);
+    cell->connect(inst, nodes[node], "A");
+    cell->connect(inst, complNodes[node], "Y");
+  }
+  return(complNodes[node]);
+}
+// --------------------- static functions ---------------------
+
+int hcmAddCellToAig(hcmAig* aig, hcmCell* flatCell, set<string>& globalNodes, string outPrefix) {
+  aigBuilder builder(aig, globalNodes);
+
+  // the input ports get their inputs in name order, before any internal net
+  map<string, hcmNode*>::const_iterator nI;
+  for (nI = flatCell->getNodes().begin(); nI != flatCell->getNodes().end(); nI++) {
+    const hcmPort* port = (*nI).second->getPort();
+    if (port && port->getDirection() == IN) {
+      builder.nodeLits[(*nI).second] = aig->getInput((*nI).first);
+    }
+  }
+
+  // the dff outputs are inputs of the AIG
+  vector<const hcmInstance*> dffs;
+  vector<int> latches;
+  map<string, hcmInstance*>::const_iterator iI;
+  for (iI = flatCell->getInstances().begin(); iI != flatCell->getInstances().end(); iI++) {
+    const hcmInstance* inst = (*iI).second;
+    if (hcmGetGateType(inst->masterCell()->getName()) != GATE_DFF) {
+      continue;
+    }
+    hcmAigLit lit = aig->addLatch((*iI).first);
+    map<string, hcmInstPort*>::const_iterator ipI;
+    for (ipI = inst->getInstPorts().begin(); ipI != inst->getInstPorts().end(); ipI++) {
+      if ((*ipI).second->getPort()->getDirection() == OUT) {
+        builder.nodeLits[(*ipI).second->getNode()] = lit;
+      }
+    }
+    dffs.push_back(inst);
+    latches.push_back(aig->getNumLatches() - 1);
+  }
+
+  for (nI = flatCell->getNodes().begin(); nI != flatCell->getNodes().end(); nI++) {
+    const hcmPort* port = (*nI).second->getPort();
+    if (port && port->getDirection() == OUT) {
+      aig->addOutput(outPrefix + (*nI).first, builder.getNodeLit((*nI).second));
+    }
+  }
+  for (size_t d = 0; d < dffs.size(); d++) {
+    const hcmInstPort* dPin = dffs[d]->getInstPort(dffs[d]->getName() + "%D");
+    const hcmInstPort* clkPin = dffs[d]->getInstPort(dffs[d]->getName() + "%CLK");
+    hcmAigLit next = dPin ? builder.getNodeLit(dPin->getNode()) : AIG_FALSE;
+    hcmAigLit clk = clkPin ? builder.getNodeLit(clkPin->getNode()) : AIG_FALSE;
+    aig->setLatchNext(latches[d], next, clk);
+    aig->addOutput(outPrefix + dffs[d]->getName() + "_D", next);
+  }
+  return(builder.anyErr ? -1 : 0);
+}
+
+hcmAig* hcmCellToAig(hcmCell* flatCell, set<string>& globalNodes) {
+  hcmAig* aig = new hcmAig();
+  if (hcmAddCellToAig(aig, flatCell, globalNodes)) {
+    delete aig;
+    return(NULL);
+  }
+  return(aig);
+}
+
+hcmCell* hcmAigToCell(hcmAig* aig, hcmDesign* design, string cellName) {
+  hcmCell* and2 = design->getCell("and2");
+  hcmCell* inv = design->getCell("inv");
+  hcmCell* buffer = design->getCell("buffer");
+  hcmCell* dff = design->getCell("dff");
+  if (!inv) {
+    inv = design->getCell("not");
+  }
+  if (!and2 || !inv || !buffer || (aig->getNumLatches() && !dff)) {
+    cerr << "-E- The design is missing one of the and2, inv, buffer or dff cells" << endl;
+    return(NULL);
+  }
+  hcmCell* cell = design->createCell(cellName);
+  if (!cell) {
+    return(NULL);
+  }
+
+  vector<hcmNode*> nodes(aig->getNumNodes(), (hcmNode*)NULL);
+  vector<hcmNode*> complNodes(aig->getNumNodes(), (hcmNode*)NULL);
+  vector<bool> isLatch(aig->getNumInputs(), false);
+  for (int l = 0; l < aig->getNumLatches(); l++) {
+    isLatch[aig->getLatchInput(l)] = true;
+  }
+  for (int i = 0; i < aig->getNumInputs(); i++) {
+    hcmNode* node = cell->createNode(aig->getInputName(i));
+    if (!isLatch[i]) {
+      node->createPort(IN);
+    }
+    nodes[aig->getInputNode(i)] = node;
+  }
+
+  for (int n = 1; n < aig->getNumNodes(); n++) {
+    if (!aig->isAnd(n)) {
+      continue;
+    }
+    ostringstream name;
+    name << "aig_n" << n;
+    nodes[n] = cell->createNode(name.str());
+    hcmInstance* inst = cell->createInst(string("and_") + name.str(), and2);
+    cell->connect(inst, getLitNode(cell, nodes, complNodes, inv, aig->getFanin0(n)), "A");
+    cell->connect(inst, getLitNode(cell, nodes, complNodes, inv, aig->getFanin1(n)), "B");
+    cell->connect(inst, nodes[n], "Y");
+  }
+
+  for (int l = 0; l < aig->getNumLatches(); l++) {
+    int input = aig->getLatchInput(l);
+    hcmInstance* inst = cell->createInst(aig->getInputName(input), dff);
+    cell->connect(inst, getLitNode(cell, nodes, complNodes, inv, aig->getLatchNext(l)), "D");
+    cell->connect(inst, getLitNode(cell, nodes, complNodes, inv, aig->getLatchClk(l)), "CLK");
+    cell->connect(inst, nodes[aig->getInputNode(input)], "Q");
+  }
+
+  // the next state outputs of the dffs are internal in the cell
+  set<string> nextNames;
+  for (int l = 0; l < aig->getNumLatches(); l++) {
+    nextNames.insert(aig->getInputName(aig->getLatchInput(l)) + "_D");
+  }
+  for (int o = 0; o < aig->getNumOutputs(); o++) {
+    if (nextNames.find(aig->getOutputName(o)) != nextNames.end()) {
+      continue;
+    }
+    hcmNode* node = cell->createNode(aig->getOutputName(o));
+    node->createPort(OUT);
+    ostringstream name;
+    name << "buf_aig_o" << o;
+    hcmInstance* inst = cell->createInst(name.str(), buffer);
+    cell->connect(inst, getLitNode(cell, nodes, complNodes, inv, aig->getOutputLit(o)), "A");
+    cell->connect(inst, node, "Y");
+  }
+  return(cell);
+}
@@ -0,0 +1,175 @@
+#ifndef __AIG_H__
+#define __AIG_H__
+#include "hcm.h"
+#include <set>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ * a literal of the AIG - the index of a node times two, plus one if complemented.
+ * node 0 is the constant 0 node so literal 0 is false and literal 1 is true.
+ */
+typedef unsigned int hcmAigLit;
+
+#define AIG_FALSE ((hcmAigLit)0)
+#define AIG_TRUE  ((hcmAigLit)1)
+
+inline hcmAigLit aigNot(hcmAigLit lit) { return(lit ^ 1); }
+inline unsigned int aigNode(hcmAigLit lit) { return(lit >> 1); }
+inline bool aigIsCompl(hcmAigLit lit) { return(lit & 1); }
+
+/**
+ * hcmAig class represent combinational logic as a graph of two input and gates and inverted edges.
+ * and gates are structurally hashed - creating an and of the same two literals twice returns the
+ * same node, so identical logic added from different cells is shared.
+ * nodes are created after their fanins, so the node order is a topological order.
+ * inputs are identified by name, adding two cells with the same input names shares their inputs.
+ * the state of a dff is an input of the AIG (the Q value) and an output (the next state on D).
+ * hcmAig is a mutable object.
+ */
+class hcmAig {
+  private:
+    // per node - the two fanin literals of an and node, both 0 for inputs and the constant node.
+    vector<hcmAigLit> fanin0;
+    vector<hcmAigLit> fanin1;
+    // per node - the number of and nodes on the longest path from an input
+    vector<int> level;
+
+    // the input nodes in creation order, their names and the mapping back from a name
+    vector<unsigned int> inputNodes;
+    vector<string> inputNames;
+    map<string, hcmAigLit> inputByName;
+
+    // the outputs in creation order
+    vector<hcmAigLit> outputLits;
+    vector<string> outputNames;
+
+    // per dff - the index of its Q input, its next state and its clock literals
+    vector<int> latchInput;
+    vector<hcmAigLit> latchNext;
+    vector<hcmAigLit> latchClk;
+
+    // strash - mapping from the (smaller, larger) fanin literal pair to the and node
+    unordered_map<uint64_t, unsigned int> strash;
+    int numStrashHits;
+
+  public:
+    hcmAig();
+
+    /** @fn hcmAigLit getInput(string name)
+     * @brief gets the literal of the named input, creating the input on first use.
+     */
+    hcmAigLit getInput(string name);
+
+    /** @fn hcmAigLit createAnd(hcmAigLit a, hcmAigLit b)
+     * @brief gets the literal of a & b, reusing an existing node of the same fanins.
+     * trivial cases (constants, a & a, a & !a) do not create a node.
+     */
+    hcmAigLit createAnd(hcmAigLit a, hcmAigLit b);
+    hcmAigLit createOr(hcmAigLit a, hcmAigLit b) { return(aigNot(createAnd(aigNot(a), aigNot(b)))); };
+    hcmAigLit createXor(hcmAigLit a, hcmAigLit b);
+
+    /** @fn hcmAigLit createAnd(const vector<hcmAigLit>& lits)
+     * @brief gets the literal of the and of all \a lits, built as a balanced tree.
+     */
+    hcmAigLit createAnd(const vector<hcmAigLit>& lits);
+
+    /** @fn int addOutput(string name, hcmAigLit lit)
+     * @brief add a named output.
+     * @return the index of the new output
+     */
+    int addOutput(string name, hcmAigLit lit);
+
+    /** @fn hcmAigLit addLatch(string name)
+     * @brief add a dff, its Q value is a new input named \a name.
+     * @return the literal of the Q input
+     */
+    hcmAigLit addLatch(string name);
+
+    /** @fn void setLatchNext(int latch, hcmAigLit next, hcmAigLit clk)
+     * @brief set the next state (D) and clock literals of the dff.
+     */
+    void setLatchNext(int latch, hcmAigLit next, hcmAigLit clk);
+
+    int getNumNodes() const { return(fanin0.size()); };
+    int getNumAnds() const { return(fanin0.size() - inputNodes.size() - 1); };
+    int getNumInputs() const { return(inputNodes.size()); };
+    int getNumOutputs() const { return(outputLits.size()); };
+    int getNumLatches() const { return(latchInput.size()); };
+    int getNumStrashHits() const { return(numStrashHits); };
+
+    bool isAnd(unsigned int node) const { return(fanin0[node] != 0 || fanin1[node] != 0); };
+    hcmAigLit getFanin0(unsigned int node) const { return(fanin0[node]); };
+    hcmAigLit getFanin1(unsigned int node) const { return(fanin1[node]); };
+    int getLevel(unsigned int node) const { return(level[node]); };
+
+    /** @fn int getDepth() const
+     * @brief gets the largest level of an output or a next state.
+     */
+    int getDepth() const;
+
+    unsigned int getInputNode(int input) const { return(inputNodes[input]); };
+    const string& getInputName(int input) const { return(inputNames[input]); };
+    /** @fn int findInput(string name) const
+     * @return the index of the named input, -1 if not found
+     */
+    int findInput(string name) const;
+
+    hcmAigLit getOutputLit(int output) const { return(outputLits[output]); };
+    const string& getOutputName(int output) const { return(outputNames[output]); };
+
+    int getLatchInput(int latch) const { return(latchInput[latch]); };
+    hcmAigLit getLatchNext(int latch) const { return(latchNext[latch]); };
+    hcmAigLit getLatchClk(int latch) const { return(latchClk[latch]); };
+
+    /** @fn void simulate(const vector<uint64_t>& inputWords, vector<uint64_t>& nodeWords) const
+     * @brief evaluate 64 patterns at once, bit i of every word belongs to pattern i.
+     * @param inputWords - the value of each input (indexed as the inputs)
+     * @param nodeWords - returns the value of each node
+     */
+    void simulate(const vector<uint64_t>& inputWords, vector<uint64_t>& nodeWords) const;
+
+    /** @fn static uint64_t getLitWord(const vector<uint64_t>& nodeWords, hcmAigLit lit)
+     * @brief gets the simulated value of a literal from the node values.
+     */
+    static uint64_t getLitWord(const vector<uint64_t>& nodeWords, hcmAigLit lit) {
+      return(aigIsCompl(lit) ? ~nodeWords[aigNode(lit)] : nodeWords[aigNode(lit)]);
+    };
+
+    /** @fn void printStats(ostream& out) const
+     * @brief print the number of inputs, outputs, dffs, and nodes and the depth.
+     */
+    void printStats(ostream& out) const;
+};
+
+/** @fn int hcmAddCellToAig(hcmAig* aig, hcmCell* flatCell, set<string>& globalNodes, string outPrefix)
+ * @brief add the logic of a flat cell of the standard cell library to the AIG.
+ * the input ports become inputs of the same name (VDD and VSS are the constants, other global
+ * nodes are inputs), undriven nets become inputs named after the net, the output ports become
+ * outputs named \a outPrefix + the port name and every dff becomes a latch named after the
+ * instance with the next state output \a outPrefix + instance + "_D".
+ * @param aig - the AIG to add to
+ * @param flatCell - pointer to a flat hcmCell (only leaf instances)
+ * @param globalNodes - refernce to set<string> containing all the global nodes
+ * @param outPrefix - prefix of the output names
+ * @return 0 on success, -1 on unknown cell or combinational loop
+ */
+int hcmAddCellToAig(hcmAig* aig, hcmCell* flatCell, set<string>& globalNodes, string outPrefix = "");
+
+/** @fn hcmAig* hcmCellToAig(hcmCell* flatCell, set<string>& globalNodes)
+ * @brief create a new AIG of the flat cell.
+ * @return pointer to the new AIG owned by the caller, NULL on error
+ */
+hcmAig* hcmCellToAig(hcmCell* flatCell, set<string>& globalNodes);
+
+/** @fn hcmCell* hcmAigToCell(hcmAig* aig, hcmDesign* design, string cellName)
+ * @brief create a flat cell of and2, inv, buffer and dff instances implementing the AIG.
+ * the design should contain these cells of the standard cell library.
+ * @return pointer to the new cell, NULL on error
+ */
+hcmCell* hcmAigToCell(hcmAig* aig, hcmDesign* design, string cellName);
+
+#endif //__AIG_H__
@@ -0,0 +1,159 @@
+#include <errno.h>
+#include <signal.h>
+#include <sstream>
+#include <fstream>
+#include <time.h>
+#include "hcm.h"
+#include "flat.h"
+#include "aig.h"
+#include "vlgwriter.h"
+
+using namespace std;
+
+bool verbose = false;
+
+/** @fn static uint64_t randWord(uint64_t& state)
+ * @brief xorshift64 pseudo random 64 bit word.
+ */
+static uint64_t randWord(uint64_t& state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return(state);
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv) {
+  int argIdx = 1;
+  int anyErr = 0;
+  unsigned int i;
+  vector<string> vlgFiles;
+  bool writeCell = false;
+  int numRounds = 0;
+
+  if (argc < 3) {
+    anyErr++;
+  } else {
+    if (!strcmp(argv[argIdx], "-v")) {
+      argIdx++;
+      verbose = true;
+    }
+    if (!strcmp(argv[argIdx], "-w")) {
+      argIdx++;
+      writeCell = true;
+    }
+    if (argIdx + 1 < argc && !strcmp(argv[argIdx], "-r")) {
+      numRounds = atoi(argv[argIdx + 1]);
+      argIdx += 2;
+    }
+    for (;argIdx < argc; argIdx++) {
+      vlgFiles.push_back(argv[argIdx]);
+    }
+
+    if (vlgFiles.size() < 2) {
+      cerr << "-E- At least top-level and single verilog file required for spec model" << endl;
+      anyErr++;
+    }
+  }
+
+  if (anyErr) {
+    cerr << "Usage: " << argv[0] << "  [-v] [-w] [-r rounds] top-cell file1.v [file2.v] ... \n";
+    exit(1);
+  }
+
+  set< string> globalNodes;
+  globalNodes.insert("VDD");
+  globalNodes.insert("VSS");
+
+  hcmDesign* design = new hcmDesign("design");
+  string cellName = vlgFiles[0];
+  for (i = 1; i < vlgFiles.size(); i++) {
+    printf("-I- Parsing verilog %s ...\n", vlgFiles[i].c_str());
+    if (!design->parseStructuralVerilog(vlgFiles[i].c_str())) {
+      cerr << "-E- Could not parse: " << vlgFiles[i] << " aborting." << endl;
+      exit(1);
+    }
+  }
+
+  hcmCell *topCell = design->getCell(cellName);
+  if (!topCell) {
+    printf("-E- could not find cell %s\n", cellName.c_str());
+    exit(1);
+  }
+
+  hcmCell *flatCell = hcmFlatten(cellName + string("_flat"), topCell, globalNodes);
+  cout << "-I- Top cell flattened: " << flatCell->getInstances().size() << " instances" << endl;
+
+  hcmAig* aig = hcmCellToAig(flatCell, globalNodes);
+  if (!aig) {
+    cerr << "-E- Could not convert " << cellName << " to AIG" << endl;
+    exit(1);
+  }
+  aig->printStats(cout);
+
+  // random bit parallel simulation, 64 patterns per round
+  if (numRounds > 0) {
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    uint64_t signature = 0;
+    vector<uint64_t> inputWords(aig->getNumInputs());
+    vector<uint64_t> nodeWords;
+    clock_t start = clock();
+    for (int r = 0; r < numRounds; r++) {
+      for (int in = 0; in < aig->getNumInputs(); in++) {
+        inputWords[in] = randWord(state);
+      }
+      aig->simulate(inputWords, nodeWords);
+      for (int o = 0; o < aig->getNumOutputs(); o++) {
+        signature = (signature * 31) ^ hcmAig::getLitWord(nodeWords, aig->getOutputLit(o));
+      }
+    }
+    double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+    cout << "-I- Simulated " << 64 * (long)numRounds << " patterns in " << secs << " sec, signature "
+         << hex << signature << dec << endl;
+  }
+
+  if (writeCell) {
+    hcmCell* aigCell = hcmAigToCell(aig, design, cellName + string("_aig"));
+    if (!aigCell) {
+      cerr << "-E- Could not convert the AIG of " << cellName << " back to a cell" << endl;
+      exit(1);
+    }
+    string aigVlgFileName = cellName + string("_aig.v");
+    hcmWriteCellVerilog(aigCell, aigVlgFileName);
+
+    // the cell written must have the same function, compare its AIG on random patterns
+    hcmAig* aig2 = hcmCellToAig(aigCell, globalNodes);
+    if (!aig2 || aig2->getNumOutputs() != aig->getNumOutputs()) {
+      cerr << "-E- Round trip check failed: could not convert " << aigCell->getName() << endl;
+      exit(1);
+    }
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    vector<uint64_t> inputWords(aig->getNumInputs()), inputWords2(aig2->getNumInputs());
+    vector<uint64_t> nodeWords, nodeWords2;
+    for (int r = 0; r < 16; r++) {
+      for (int in = 0; in < aig->getNumInputs(); in++) {
+        inputWords[in] = randWord(state);
+      }
+      for (int in = 0; in < aig2->getNumInputs(); in++) {
+        int orig = aig->findInput(aig2->getInputName(in));
+        inputWords2[in] = (orig < 0) ? 0 : inputWords[orig];
+      }
+      aig->simulate(inputWords, nodeWords);
+      aig2->simulate(inputWords2, nodeWords2);
+      for (int o = 0; o < aig->getNumOutputs(); o++) {
+        if (aig->getOutputName(o) != aig2->getOutputName(o) ||
+            hcmAig::getLitWord(nodeWords, aig->getOutputLit(o)) !=
+            hcmAig::getLitWord(nodeWords2, aig2->getOutputLit(o))) {
+          cerr << "-E- Round trip check failed on output: " << aig->getOutputName(o) << endl;
+          exit(1);
+        }
+      }
+    }
+    cout << "-I- Round trip check passed" << endl;
+    delete aig2;
+  }
+
+  delete aig;
+  return(0);
+}
@@ -0,0 +1,442 @@
+#include "cleanup.h"
+#include "gates.h"
+#include <list>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+// --------------------- static functions ---------------------
+/** @fn static bool isFixedNode(hcmNode* node, set<string>& globalNodes)
+ * @brief nodes which are ports of the cell or global nodes can not be merged or removed.
+ */
+static bool isFixedNode(hcmNode* node, set<string>& globalNodes) {
+  return(node->getPort() != NULL || globalNodes.find(node->getName()) != globalNodes.end());
+}
+
+/** @fn static hcmInstPort* getOutPin(hcmInstance* inst)
+ * @brief gets the pin of the output port of the gate, NULL if not connected.
+ */
+static hcmInstPort* getOutPin(hcmInstance* inst) {
+  map<string, hcmInstPort*>::iterator ipI;
+  for (ipI = inst->getInstPorts().begin(); ipI != inst->getInstPorts().end(); ipI++) {
+    if ((*ipI).second->getPort()->getDirection() == OUT) {
+      return((*ipI).second);
+    }
+  }
+  return(NULL);
+}
+
+/** @fn static vector<hcmInstPort*> getInPins(hcmInstance* inst)
+ * @brief gets the pins of the input ports of the gate in port name order.
+ */
+static vector<hcmInstPort*> getInPins(hcmInstance* inst) {
+  vector<hcmInstPort*> pins;
+  map<string, hcmInstPort*>::iterator ipI;
+  for (ipI = inst->getInstPorts().begin(); ipI != inst->getInstPorts().end(); ipI++) {
+    if ((*ipI).second->getPort()->getDirection() == IN) {
+      pins.push_back((*ipI).second);
+    }
+  }
+  return(pins);
+}
+
+/** @fn static hcmInstance* getDriver(hcmNode* node)
+ * @brief gets the gate driving the node, NULL if none.
+ */
+static hcmInstance* getDriver(hcmNode* node) {
+  map<string, hcmInstPort*>::iterator ipI;
+  for (ipI = node->getInstPorts().begin(); ipI != node->getInstPorts().end(); ipI++) {
+    if ((*ipI).second->getPort()->getDirection() == OUT) {
+      return((*ipI).second->getInst());
+    }
+  }
+  return(NULL);
+}
+
+/** @fn static void moveFanout(hcmCell* cell, hcmNode* from, hcmNode* to, hcmInstance* except, list<string>* touched)
+ * @brief reconnect all the pins of \a from, except the ones of \a except, to \a to.
+ * @param touched - if not NULL the names of the reconnected instances are appended to it
+ */
+static void moveFanout(hcmCell* cell, hcmNode* from, hcmNode* to, hcmInstance* except, list<string>* touched) {
+  vector<hcmInstPort*> pins;
+  map<string, hcmInstPort*>::iterator ipI;
+  for (ipI = from->getInstPorts().begin(); ipI != from->getInstPorts().end(); ipI++) {
+    if ((*ipI).second->getInst() != except) {
+      pins.push_back((*ipI).second);
+    }
+  }
+  for (size_t i = 0; i < pins.size(); i++) {
+    hcmInstance* inst = pins[i]->getInst();
+    hcmPort* port = pins[i]->getPort();
+    hcmCell::disConnect(pins[i]);
+    cell->connect(inst, to, port);
+    if (touched) {
+      touched->push_back(inst->getName());
+    }
+  }
+}
+
+/** @fn static void removeGate(hcmCell* cell, hcmInstance* inst, set<string>& globalNodes)
+ * @brief delete the gate and the nodes it leaves unconnected.
+ */
+static void removeGate(hcmCell* cell, hcmInstance* inst, set<string>& globalNodes) {
+  vector<hcmNode*> nodes;
+  map<string, hcmInstPort*>::iterator ipI;
+  for (ipI = inst->getInstPorts().begin(); ipI != inst->getInstPorts().end(); ipI++) {
+    nodes.push_back((*ipI).second->getNode());
+  }
+  cell->deleteInst(inst->getName());
+  for (size_t i = 0; i < nodes.size(); i++) {
+    if (nodes[i]->getInstPorts().empty() && !isFixedNode(nodes[i], globalNodes) &&
+        cell->getNode(nodes[i]->getName()) == nodes[i]) {
+      cell->deleteNode(nodes[i]->getName());
+    }
+  }
+}
+
+/** @fn static hcmInstance* replaceGate(hcmCell* cell, hcmInstance* inst, hcmCell* master, vector<hcmNode*>& inputs, hcmNode* output)
+ * @brief re-create the gate with the same name as an instance of \a master,
+ * connecting the input ports of the master in name order to \a inputs.
+ */
+static hcmInstance* replaceGate(hcmCell* cell, hcmInstance* inst, hcmCell* master,
+                                vector<hcmNode*>& inputs, hcmNode* output) {
+  string name = inst->getName();
+  cell->deleteInst(name);
+  hcmInstance* newInst = cell->createInst(name, master);
+  if (!newInst) {
+    return(NULL);
+  }
+  vector<hcmPort*> ports = master->getPorts();
+  size_t in = 0;
+  for (size_t i = 0; i < ports.size(); i++) {
+    if (ports[i]->getDirection() == OUT) {
+      cell->connect(newInst, output, ports[i]);
+    }
+    else if (ports[i]->getDirection() == IN && in < inputs.size()) {
+      cell->connect(newInst, inputs[in++], ports[i]);
+    }
+  }
+  return(newInst);
+}
+
+/** @fn static string gateBaseName(hcmGateType type)
+ * @brief gets the cell name prefix of the multi input gates of the library.
+ */
+static string gateBaseName(hcmGateType type) {
+  switch (type) {
+  case GATE_AND: return("and");
+  case GATE_NAND: return("nand");
+  case GATE_OR: return("or");
+  case GATE_NOR: return("nor");
+  default: return("");
+  }
+}
+
+/** @fn static void forgetFlatModels(hcmCell* flatCell)
+ * @brief the flat cell is memoized by hcmFlatten as the flat model of its source cell, so
+ * the memoized models are dropped before editing it. otherwise a later flattening of that
+ * cell would stitch the cleaned netlist.
+ */
+static void forgetFlatModels(hcmCell* flatCell) {
+  if (flatCell->owner()) {
+    flatCell->owner()->clearFlatCells();
+  }
+}
+// --------------------- static functions ---------------------
+
+int hcmPropagateConstants(hcmCell* flatCell, set<string>& globalNodes) {
+  forgetFlatModels(flatCell);
+  hcmNode* constNodes[2];
+  constNodes[0] = globalNodes.count("VSS") ? flatCell->getNode("VSS") : NULL;
+  constNodes[1] = globalNodes.count("VDD") ? flatCell->getNode("VDD") : NULL;
+  hcmDesign* design = flatCell->owner();
+  int removed = 0;
+
+  // start from the gates connected to the constants and continue to their fanout
+  list<string> work;
+  for (int v = 0; v < 2; v++) {
+    if (!constNodes[v]) {
+      continue;
+    }
+    map<string, hcmInstPort*>::iterator ipI;
+    for (ipI = constNodes[v]->getInstPorts().begin(); ipI != constNodes[v]->getInstPorts().end(); ipI++) {
+      work.push_back((*ipI).second->getInst()->getName());
+    }
+  }
+
+  while (!work.empty()) {
+    hcmInstance* inst = flatCell->getInst(work.front());
+    work.pop_front();
+    if (!inst) {
+      continue;
+    }
+    hcmGateType type = hcmGetGateType(inst->masterCell()->getName());
+    hcmInstPort* outPin = getOutPin(inst);
+    if (type == GATE_UNKNOWN || type == GATE_DFF || !outPin) {
+      continue;
+    }
+
+    // split the inputs into constant values and the rest
+    vector<hcmInstPort*> inPins = getInPins(inst);
+    vector<hcmNode*> live;
+    int numOnes = 0, numZeros = 0;
+    for (size_t i = 0; i < inPins.size(); i++) {
+      hcmNode* node = inPins[i]->getNode();
+      if (node == constNodes[1]) {
+        numOnes++;
+      }
+      else if (node == constNodes[0]) {
+        numZeros++;
+      }
+      else {
+        live.push_back(node);
+      }
+    }
+    if (live.size() == inPins.size()) {
+      continue;
+    }
+
+    int out = -1;
+    bool invert = (type == GATE_NAND || type == GATE_NOR || type == GATE_NOT);
+    string newMaster;
+    switch (type) {
+    case GATE_BUFFER:
+    case GATE_NOT:
+      out = numOnes;
+      break;
+    case GATE_AND:
+    case GATE_NAND:
+      if (numZeros || live.empty()) {
+        out = numZeros ? 0 : 1;
+      }
+      break;
+    case GATE_OR:
+    case GATE_NOR:
+      if (numOnes || live.empty()) {
+        out = numOnes ? 1 : 0;
+      }
+      break;
+    case GATE_XOR:
+      if (live.empty()) {
+        out = numOnes & 1;
+      }
+      else {
+        newMaster = (numOnes & 1) ? "inv" : "buffer";
+      }
+      break;
+    default:
+      break;
+    }
+    if (out >= 0 && invert) {
+      out = !out;
+    }
+
+    hcmNode* outNode = outPin->getNode();
+    if (out >= 0) {
+      if (!constNodes[out] || isFixedNode(outNode, globalNodes)) {
+        continue;
+      }
+      moveFanout(flatCell, outNode, constNodes[out], inst, &work);
+      removeGate(flatCell, inst, globalNodes);
+      removed++;
+      continue;
+    }
+
+    // drop the non controlling constant inputs
+    if (newMaster.empty()) {
+      if (live.size() == 1) {
+        newMaster = invert ? "inv" : "buffer";
+      }
+      else {
+        ostringstream name;
+        name << gateBaseName(type) << live.size();
+        newMaster = name.str();
+      }
+    }
+    hcmCell* master = design->getCell(newMaster);
+    if (!master && newMaster == "inv") {
+      master = design->getCell("not");
+    }
+    if (master) {
+      replaceGate(flatCell, inst, master, live, outNode);
+    }
+  }
+  return(removed);
+}
+
+int hcmCollapseBuffers(hcmCell* flatCell, set<string>& globalNodes) {
+  forgetFlatModels(flatCell);
+  int removed = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    vector<string> names;
+    map<string, hcmInstance*>::iterator iI;
+    for (iI = flatCell->getInstances().begin(); iI != flatCell->getInstances().end(); iI++) {
+      names.push_back((*iI).first);
+    }
+
+    for (size_t n = 0; n < names.size(); n++) {
+      hcmInstance* inst = flatCell->getInst(names[n]);
+      if (!inst) {
+        continue;
+      }
+      hcmGateType type = hcmGetGateType(inst->masterCell()->getName());
+      if (type != GATE_BUFFER && type != GATE_NOT) {
+        continue;
+      }
+      hcmInstPort* outPin = getOutPin(inst);
+      vector<hcmInstPort*> inPins = getInPins(inst);
+      if (!outPin || inPins.size() != 1) {
+        continue;
+      }
+      hcmNode* in = inPins[0]->getNode();
+      hcmNode* out = outPin->getNode();
+      if (in == out) {
+        continue;
+      }
+
+      if (type == GATE_BUFFER) {
+        if (!isFixedNode(out, globalNodes)) {
+          moveFanout(flatCell, out, in, inst, NULL);
+        }
+        else if (!isFixedNode(in, globalNodes)) {
+          moveFanout(flatCell, in, out, inst, NULL);
+        }
+        else {
+          continue;
+        }
+        removeGate(flatCell, inst, globalNodes);
+        removed++;
+        changed = true;
+        continue;
+      }
+
+      // an inverter driven by another inverter: connect its fanout to the input of the first
+      hcmInstance* first = getDriver(in);
+      if (!first || first == inst || hcmGetGateType(first->masterCell()->getName()) != GATE_NOT) {
+        continue;
+      }
+      vector<hcmInstPort*> firstIns = getInPins(first);
+      if (firstIns.size() != 1 || firstIns[0]->getNode() == out || isFixedNode(out, globalNodes)) {
+        continue;
+      }
+      moveFanout(flatCell, out, firstIns[0]->getNode(), inst, NULL);
+      removeGate(flatCell, inst, globalNodes);
+      removed++;
+      if (in->getInstPorts().size() == 1 && !isFixedNode(in, globalNodes)) {
+        removeGate(flatCell, first, globalNodes);
+        removed++;
+      }
+      changed = true;
+    }
+  }
+  return(removed);
+}
+
+int hcmSweepDeadLogic(hcmCell* flatCell, set<string>& globalNodes) {
+  forgetFlatModels(flatCell);
+  set<hcmInstance*> live;
+  list<hcmNode*> work;
+  set<hcmNode*> visited;
+
+  // the output ports and the inputs of the state and unknown cells are observed
+  map<string, hcmNode*>::iterator nI;
+  for (nI = flatCell->getNodes().begin(); nI != flatCell->getNodes().end(); nI++) {
+    hcmPort* port = (*nI).second->getPort();
+    if (port && port->getDirection() != IN) {
+      work.push_back((*nI).second);
+    }
+  }
+  map<string, hcmInstance*>::iterator iI;
+  for (iI = flatCell->getInstances().begin(); iI != flatCell->getInstances().end(); iI++) {
+    hcmGateType type = hcmGetGateType((*iI).second->masterCell()->getName());
+    if (type == GATE_DFF || type == GATE_UNKNOWN) {
+      live.insert((*iI).second);
+      map<string, hcmInstPort*>::iterator ipI;
+      for (ipI = (*iI).second->getInstPorts().begin(); ipI != (*iI).second->getInstPorts().end(); ipI++) {
+        if ((*ipI).second->getPort()->getDirection() != OUT) {
+          work.push_back((*ipI).second->getNode());
+        }
+      }
+    }
+  }
+
+  // walk backward through the drivers
+  while (!work.empty()) {
+    hcmNode* node = work.front();
+    work.pop_front();
+    if (!visited.insert(node).second) {
+      continue;
+    }
+    map<string, hcmInstPort*>::iterator ipI;
+    for (ipI = node->getInstPorts().begin(); ipI != node->getInstPorts().end(); ipI++) {
+      hcmInstPort* instPort = (*ipI).second;
+      if (instPort->getPort()->getDirection() == IN || !live.insert(instPort->getInst()).second) {
+        continue;
+      }
+      vector<hcmInstPort*> inPins = getInPins(instPort->getInst());
+      for (size_t i = 0; i < inPins.size(); i++) {
+        work.push_back(inPins[i]->getNode());
+      }
+    }
+  }
+
+  int removed = 0;
+  vector<hcmInstance*> dead;
+  for (iI = flatCell->getInstances().begin(); iI != flatCell->getInstances().end(); iI++) {
+    if (live.find((*iI).second) == live.end()) {
+      dead.push_back((*iI).second);
+    }
+  }
+  for (size_t i = 0; i < dead.size(); i++) {
+    removeGate(flatCell, dead[i], globalNodes);
+    removed++;
+  }
+  return(removed);
+}
+
+int hcmCleanupCell(hcmCell* flatCell, set<string>& globalNodes, int passes) {
+  int removed, total = 0;
+  if (passes & CLEANUP_CONST) {
+    removed = hcmPropagateConstants(flatCell, globalNodes);
+    cout << "-I- Constant propagation removed " << removed << " gates" << endl;
+    total += removed;
+  }
+  if (passes & CLEANUP_BUF) {
+    removed = hcmCollapseBuffers(flatCell, globalNodes);
+    cout << "-I- Buffer collapsing removed " << removed << " gates" << endl;
+    total += removed;
+  }
+  if (passes & CLEANUP_DEAD) {
+    removed = hcmSweepDeadLogic(flatCell, globalNodes);
+    cout << "-I- Dead logic sweep removed " << removed << " gates" << endl;
+    total += removed;
+  }
+  return(total);
+}
+
+int hcmParseCleanupPasses(string passes) {
+  int res = CLEANUP_NONE;
+  istringstream in(passes);
+  string pass;
+  while (getline(in, pass, ',')) {
+    if (pass == "const") {
+      res |= CLEANUP_CONST;
+    }
+    else if (pass == "buf") {
+      res |= CLEANUP_BUF;
+    }
+    else if (pass == "dead") {
+      res |= CLEANUP_DEAD;
+    }
+    else if (pass == "all") {
+      res |= CLEANUP_ALL;
+    }
+    else {
+      return(-1);
+    }
+  }
+  return(res);
+}
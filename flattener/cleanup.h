@@ -0,0 +1,69 @@
+#ifndef __CLEANUP_H__
+#define __CLEANUP_H__
+#include "hcm.h"
+#include <set>
+
+using namespace std;
+
+/*! \var typedef enum hcmCleanupPasses hcmCleanupPass
+    \brief the netlist cleanup passes, may be or-ed together.
+*/
+typedef enum hcmCleanupPasses {
+  CLEANUP_NONE = 0,
+  CLEANUP_CONST = 1,                    /**< Constant propagation from the global nodes.*/
+  CLEANUP_BUF = 2,                      /**< Buffer and double inverter collapsing.*/
+  CLEANUP_DEAD = 4,                     /**< Removal of logic not reaching an output.*/
+  CLEANUP_ALL = 7
+} hcmCleanupPass;
+
+// every pass edits the flat cell in place and drops the flat models memoized on its design,
+// so flattening a cell again after a cleanup builds its flat model from the folded cells.
+
+/** @fn int hcmPropagateConstants(hcmCell* flatCell, set<string>& globalNodes)
+ * @brief propagate the values of the VDD (1) and VSS (0) global nodes through the gates of the flat cell.
+ * gates with a constant output are removed and their fanout is connected to VDD/VSS,
+ * constant non-controlling inputs are dropped by replacing the gate with a narrower one
+ * of the same library (e.g and3 to and2, and2 to buffer) if the design has it.
+ * gates driving a port of the cell are never removed.
+ * @param flatCell - pointer to a flat hcmCell (only leaf instances)
+ * @param globalNodes - refernce to set<string> containing all the global nodes
+ * @return the number of gates removed
+ */
+int hcmPropagateConstants(hcmCell* flatCell, set<string>& globalNodes);
+
+/** @fn int hcmCollapseBuffers(hcmCell* flatCell, set<string>& globalNodes)
+ * @brief remove buffers and pairs of inverters in series by merging the nets they connect.
+ * a buffer between two ports of the cell is kept. as each removed gate is a unit
+ * delay the timing of event driven simulation changes (e.g the inverter delay chain of stdcell_FF.v dff).
+ * @param flatCell - pointer to a flat hcmCell (only leaf instances)
+ * @param globalNodes - refernce to set<string> containing all the global nodes
+ * @return the number of gates removed
+ */
+int hcmCollapseBuffers(hcmCell* flatCell, set<string>& globalNodes);
+
+/** @fn int hcmSweepDeadLogic(hcmCell* flatCell, set<string>& globalNodes)
+ * @brief remove all the gates not in the fanin cone of an output port, a dff or a cell
+ * outside the standard cell library, and the nodes left unconnected.
+ * @param flatCell - pointer to a flat hcmCell (only leaf instances)
+ * @param globalNodes - refernce to set<string> containing all the global nodes
+ * @return the number of gates removed
+ */
+int hcmSweepDeadLogic(hcmCell* flatCell, set<string>& globalNodes);
+
+/** @fn int hcmCleanupCell(hcmCell* flatCell, set<string>& globalNodes, int passes)
+ * @brief run the selected cleanup passes (in the order const, buf, dead) and report
+ * the number of gates each of them removed.
+ * @param flatCell - pointer to a flat hcmCell (only leaf instances)
+ * @param globalNodes - refernce to set<string> containing all the global nodes
+ * @param passes - or of hcmCleanupPass values
+ * @return the total number of gates removed
+ */
+int hcmCleanupCell(hcmCell* flatCell, set<string>& globalNodes, int passes);
+
+/** @fn int hcmParseCleanupPasses(string passes)
+ * @brief parse a comma separated list of pass names: const, buf, dead or all.
+ * @return or of hcmCleanupPass values, -1 on unknown pass name
+ */
+int hcmParseCleanupPasses(string passes);
+
+#endif //__CLEANUP_H__
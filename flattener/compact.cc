@@ -0,0 +1,262 @@
+#include "compact.h"
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * cellTmpl - the connectivity of a folded cell by node index, computed once per master cell.
+ * nodes are indexed in their name order, the same order hcmFlatten visits them.
+ */
+class cellTmpl {
+  public:
+    vector<const hcmNode*> nodes;
+    vector<bool> isPort;
+    // mapping from a node of the cell to its index
+    map<const hcmNode*, int> nodeIdx;
+    // the sub instances of the cell, the template of their master and their
+    // connections as pairs of (master node index, node index in this cell)
+    vector<const hcmInstance*> subInsts;
+    vector<cellTmpl*> subTmpls;
+    vector< vector< pair<int,int> > > subConns;
+};
+
+/**
+ * netSlot - a node of a cell in a specific context, gets a net only once a leaf is connected to it.
+ */
+struct netSlot {
+  int net;
+  int ctx;
+  const hcmNode* node;
+};
+
+int hcmCompactNetlist::addCtx(int parent, const hcmInstance* inst) {
+  ctxParent.push_back(parent);
+  ctxInst.push_back(inst);
+  return(ctxInst.size() - 1);
+}
+
+int hcmCompactNetlist::addNet(int ctx, const hcmNode* node) {
+  netNode.push_back(node);
+  netCtx.push_back(ctx);
+  netByName.clear();
+  return(netNode.size() - 1);
+}
+
+int hcmCompactNetlist::addInst(int ctx, const hcmCell* master) {
+  if (instPinBegin.empty()) {
+    instPinBegin.push_back(0);
+  }
+  instMaster.push_back(master);
+  instCtx.push_back(ctx);
+  instPinBegin.push_back(pinNet.size());
+  return(instMaster.size() - 1);
+}
+
+void hcmCompactNetlist::addPin(int net, const hcmPort* port) {
+  pinNet.push_back(net);
+  pinPort.push_back(port);
+  instPinBegin.back() = pinNet.size();
+}
+
+string hcmCompactNetlist::getCtxName(int ctx) const {
+  vector<int> path;
+  for (; ctx >= 0; ctx = ctxParent[ctx]) {
+    path.push_back(ctx);
+  }
+  string res;
+  for (int i = path.size() - 1; i >= 0; i--) {
+    res += ctxInst[path[i]]->getName();
+    if (i) {
+      res += string("/");
+    }
+  }
+  return(res);
+}
+
+string hcmCompactNetlist::getInstName(int inst) const {
+  return(getCtxName(instCtx[inst]));
+}
+
+string hcmCompactNetlist::getNetName(int net) const {
+  if (netCtx[net] < 0) {
+    return(netNode[net]->getName());
+  }
+  return(getCtxName(netCtx[net]) + string("/") + netNode[net]->getName());
+}
+
+int hcmCompactNetlist::findNet(string name) {
+  if (netByName.empty()) {
+    for (int net = 0; net < getNumNets(); net++) {
+      netByName[getNetName(net)] = net;
+    }
+  }
+  map<string, int>::const_iterator nI = netByName.find(name);
+  if (nI == netByName.end()) {
+    return(-1);
+  }
+  return((*nI).second);
+}
+
+size_t hcmCompactNetlist::getMemUsage() const {
+  return(ctxParent.capacity() * sizeof(int) + ctxInst.capacity() * sizeof(const hcmInstance*) +
+         instMaster.capacity() * sizeof(const hcmCell*) + instCtx.capacity() * sizeof(int) +
+         instPinBegin.capacity() * sizeof(int) + pinNet.capacity() * sizeof(int) +
+         pinPort.capacity() * sizeof(const hcmPort*) + netNode.capacity() * sizeof(const hcmNode*) +
+         netCtx.capacity() * sizeof(int) + portNets.capacity() * sizeof(int));
+}
+
+// --------------------- static functions ---------------------
+/** @fn static cellTmpl* getCellTmpl(const hcmCell* cell, map<const hcmCell*, cellTmpl*>& tmpls)
+ * @brief gets the template of the given cell, creating it and the templates of all its masters on first use.
+ * @param cell - the folded cell
+ * @param tmpls - refernce to the templates created so far
+ * @return pointer to the template of the cell
+ */
+static cellTmpl* getCellTmpl(const hcmCell* cell, map<const hcmCell*, cellTmpl*>& tmpls) {
+  map<const hcmCell*, cellTmpl*>::iterator tI = tmpls.find(cell);
+  if (tI != tmpls.end()) {
+    return((*tI).second);
+  }
+
+  cellTmpl* tmpl = new cellTmpl();
+  tmpls[cell] = tmpl;
+
+  map<string, hcmNode*>::const_iterator nI;
+  for (nI = cell->getNodes().begin(); nI != cell->getNodes().end(); nI++) {
+    const hcmNode* node = (*nI).second;
+    tmpl->nodeIdx[node] = tmpl->nodes.size();
+    tmpl->nodes.push_back(node);
+    tmpl->isPort.push_back(node->getPort() != NULL);
+  }
+
+  map<string, hcmInstance*>::const_iterator iI;
+  for (iI = cell->getInstances().begin(); iI != cell->getInstances().end(); iI++) {
+    const hcmInstance* inst = (*iI).second;
+    cellTmpl* subTmpl = getCellTmpl(inst->masterCell(), tmpls);
+    vector< pair<int,int> > conns;
+    map<string, hcmInstPort*>::const_iterator ipI;
+    for (ipI = inst->getInstPorts().begin(); ipI != inst->getInstPorts().end(); ipI++) {
+      const hcmInstPort* instPort = (*ipI).second;
+      if (instPort->getNode() == NULL || instPort->getPort() == NULL) {
+        continue;
+      }
+      map<const hcmNode*, int>::const_iterator mI = subTmpl->nodeIdx.find(instPort->getPort()->owner());
+      if (mI == subTmpl->nodeIdx.end()) {
+        continue;
+      }
+      conns.push_back(make_pair((*mI).second, tmpl->nodeIdx[instPort->getNode()]));
+    }
+    tmpl->subInsts.push_back(inst);
+    tmpl->subTmpls.push_back(subTmpl);
+    tmpl->subConns.push_back(conns);
+  }
+  return(tmpl);
+}
+
+/** @fn static int slotNet(hcmCompactNetlist* nl, netSlot* slot)
+ * @brief gets the net of the slot, creating it on first use.
+ */
+static int slotNet(hcmCompactNetlist* nl, netSlot* slot) {
+  if (slot->net < 0) {
+    slot->net = nl->addNet(slot->ctx, slot->node);
+  }
+  return(slot->net);
+}
+
+/** @fn static void flattenCompact(hcmCompactNetlist* nl, cellTmpl* tmpl, int ctx, vector<netSlot*>& refs, set<string>& globalNodes, map<string, netSlot>& globals)
+ * @brief given a context and the template of its cell add all the leaves below it to the netlist.
+ * @param nl - the compact netlist to populate
+ * @param tmpl - the template of the cell of the context
+ * @param ctx - the current context
+ * @param refs - the slot every node of the cell is bound to
+ * @param glbNodeNames - refernce to set<string> containing all the global nodes
+ * @param globals - the slots of the global nodes
+ */
+static void flattenCompact(hcmCompactNetlist* nl, cellTmpl* tmpl, int ctx, vector<netSlot*>& refs,
+                           set<string>& globalNodes, map<string, netSlot>& globals) {
+  for (size_t s = 0; s < tmpl->subInsts.size(); s++) {
+    const hcmInstance* inst = tmpl->subInsts[s];
+    cellTmpl* subTmpl = tmpl->subTmpls[s];
+    int subCtx = nl->addCtx(ctx, inst);
+
+    // bind the port nodes of the master to the slots they are connected to here
+    vector<netSlot*> subRefs(subTmpl->nodes.size(), (netSlot*)NULL);
+    vector< pair<int,int> >& conns = tmpl->subConns[s];
+    for (size_t c = 0; c < conns.size(); c++) {
+      if (subTmpl->isPort[conns[c].first]) {
+        subRefs[conns[c].first] = refs[conns[c].second];
+      }
+    }
+
+    // if got here with no sub instances must be a primitive. Add it as new instance and connect.
+    if (subTmpl->subInsts.empty()) {
+      nl->addInst(subCtx, inst->masterCell());
+      for (size_t i = 0; i < subTmpl->nodes.size(); i++) {
+        if (subRefs[i] == NULL) {
+          continue;
+        }
+        nl->addPin(slotNet(nl, subRefs[i]), subTmpl->nodes[i]->getPort());
+      }
+      continue;
+    }
+
+    // the internal nodes of the master get slots of their own unless global
+    vector<netSlot> slots(subTmpl->nodes.size());
+    for (size_t i = 0; i < subTmpl->nodes.size(); i++) {
+      if (subTmpl->isPort[i]) {
+        continue;
+      }
+      const hcmNode* node = subTmpl->nodes[i];
+      if (globalNodes.find(node->getName()) != globalNodes.end()) {
+        map<string, netSlot>::iterator gI = globals.find(node->getName());
+        if (gI == globals.end()) {
+          netSlot slot = { -1, -1, node };
+          gI = globals.insert(make_pair(node->getName(), slot)).first;
+        }
+        subRefs[i] = &((*gI).second);
+      }
+      else {
+        slots[i].net = -1;
+        slots[i].ctx = subCtx;
+        slots[i].node = node;
+        subRefs[i] = &slots[i];
+      }
+    }
+    flattenCompact(nl, subTmpl, subCtx, subRefs, globalNodes, globals);
+  }
+}
+// --------------------- static functions ---------------------
+
+hcmCompactNetlist* hcmFlattenCompact(hcmCell* topCell, set<string>& globalNodes) {
+  hcmCompactNetlist* nl = new hcmCompactNetlist();
+  map<const hcmCell*, cellTmpl*> tmpls;
+  cellTmpl* tmpl = getCellTmpl(topCell, tmpls);
+
+  // all ports of the top cell get a net, other nodes only once a leaf is connected
+  map<string, netSlot> globals;
+  vector<netSlot> slots(tmpl->nodes.size());
+  vector<netSlot*> refs(tmpl->nodes.size(), (netSlot*)NULL);
+  for (size_t i = 0; i < tmpl->nodes.size(); i++) {
+    const hcmNode* node = tmpl->nodes[i];
+    slots[i].net = -1;
+    slots[i].ctx = -1;
+    slots[i].node = node;
+    if (tmpl->isPort[i]) {
+      nl->addPortNet(slotNet(nl, &slots[i]));
+    }
+    else if (globalNodes.find(node->getName()) != globalNodes.end()) {
+      globals[node->getName()] = slots[i];
+      refs[i] = &globals[node->getName()];
+      continue;
+    }
+    refs[i] = &slots[i];
+  }
+
+  flattenCompact(nl, tmpl, -1, refs, globalNodes, globals);
+
+  map<const hcmCell*, cellTmpl*>::iterator tI;
+  for (tI = tmpls.begin(); tI != tmpls.end(); tI++) {
+    delete (*tI).second;
+  }
+  return(nl);
+}
@@ -0,0 +1,141 @@
+#ifndef __COMPACT_H__
+#define __COMPACT_H__
+#include "hcm.h"
+#include <set>
+#include <vector>
+
+using namespace std;
+
+/**
+ * hcmCompactNetlist class represent a flat netlist as plain integer arrays.
+ * leaf instances and nets are identified by their index, the pins of all instances are kept
+ * in a single array where the pins of instance i are [getInstPinBegin(i), getInstPinEnd(i)).
+ * no hcm objects are created for the flat model, the hierarchical names of instances and nets
+ * are produced on request from the hierarchy contexts they were found in.
+ * hcmCompactNetlist is a mutable object.
+ */
+class hcmCompactNetlist {
+  private:
+    // ctxParent / ctxInst - a hierarchy context, the instance it represents and the index
+    // of the context of the cell containing that instance (-1 for the top cell).
+    vector<int> ctxParent;
+    vector<const hcmInstance*> ctxInst;
+
+    // per leaf instance - its primitive master cell, its context and the index of its first pin.
+    // instPinBegin holds one more element than the number of instances.
+    vector<const hcmCell*> instMaster;
+    vector<int> instCtx;
+    vector<int> instPinBegin;
+
+    // per pin - the net it is connected to and the port of the primitive master.
+    vector<int> pinNet;
+    vector<const hcmPort*> pinPort;
+
+    // per net - the node it was created for and the context of the cell containing
+    // that node (-1 for the top cell and for global nodes).
+    vector<const hcmNode*> netNode;
+    vector<int> netCtx;
+
+    // the nets of the ports of the top cell
+    vector<int> portNets;
+
+    // netByName - mapping from the hierarchical net name to its index, built on the first lookup.
+    map<string, int> netByName;
+
+    /** @fn string getCtxName(int ctx) const
+     * @brief gets the hierarchical name of the context (i.e a/b/c).
+     * @param ctx - the index of the context
+     * @return string represantion of the context
+     */
+    string getCtxName(int ctx) const;
+
+  public:
+    hcmCompactNetlist() {};
+
+    /** @fn int addCtx(int parent, const hcmInstance* inst)
+     * @brief add a new hierarchy context.
+     * @param parent - the index of the parent context, -1 for the top cell
+     * @param inst - the instance the context represents
+     * @return the index of the new context
+     */
+    int addCtx(int parent, const hcmInstance* inst);
+
+    /** @fn int addNet(int ctx, const hcmNode* node)
+     * @brief add a new net named after \a node in the context \a ctx.
+     * @return the index of the new net
+     */
+    int addNet(int ctx, const hcmNode* node);
+
+    /** @fn int addInst(int ctx, const hcmCell* master)
+     * @brief add a new leaf instance, its pins should be added right after.
+     * @return the index of the new instance
+     */
+    int addInst(int ctx, const hcmCell* master);
+
+    /** @fn void addPin(int net, const hcmPort* port)
+     * @brief connect \a port of the last added instance to \a net.
+     */
+    void addPin(int net, const hcmPort* port);
+
+    /** @fn void addPortNet(int net)
+     * @brief mark \a net as a port of the top cell.
+     */
+    void addPortNet(int net) { portNets.push_back(net); };
+
+    int getNumInsts() const { return(instMaster.size()); };
+    int getNumNets() const { return(netNode.size()); };
+    int getNumPins() const { return(pinNet.size()); };
+
+    const hcmCell* getInstMaster(int inst) const { return(instMaster[inst]); };
+    int getInstPinBegin(int inst) const { return(instPinBegin[inst]); };
+    int getInstPinEnd(int inst) const { return(instPinBegin[inst + 1]); };
+
+    int getPinNet(int pin) const { return(pinNet[pin]); };
+    const hcmPort* getPinPort(int pin) const { return(pinPort[pin]); };
+    hcmPortDir getPinDir(int pin) const { return(pinPort[pin]->getDirection()); };
+
+    /** @fn const hcmNode* getNetNode(int net) const
+     * @brief gets the node in the folded model the net was created for.
+     * for nets of top ports this is the top cell port node.
+     */
+    const hcmNode* getNetNode(int net) const { return(netNode[net]); };
+
+    /** @fn const vector<int>& getPortNets() const
+     * @brief gets the nets of all the ports of the top cell.
+     */
+    const vector<int>& getPortNets() const { return(portNets); };
+
+    /** @fn string getInstName(int inst) const
+     * @brief gets the hierarchical name of the instance, the same name hcmFlatten gives it.
+     */
+    string getInstName(int inst) const;
+
+    /** @fn string getNetName(int net) const
+     * @brief gets the hierarchical name of the net, the same name hcmFlatten gives its node.
+     */
+    string getNetName(int net) const;
+
+    /** @fn int findNet(string name)
+     * @brief gets the index of the net with the given hierarchical name.
+     * @return the index of the net, -1 if not found
+     */
+    int findNet(string name);
+
+    /** @fn size_t getMemUsage() const
+     * @brief gets the approximate number of bytes used by the netlist arrays.
+     */
+    size_t getMemUsage() const;
+};
+
+/** @fn hcmCompactNetlist* hcmFlattenCompact(hcmCell* topCell, set<string>& globalNodes)
+ * @brief create a compact flat netlist based on the given folded model, without creating
+ * a flat hcmCell. nets and instances get the same names they would get from hcmFlatten.
+ * only the connectivity report of flattener -c is built on it for now, the simulators and the
+ * equivalence checker still work on the flat hcmCell of hcmFlatten.
+ * @param topCell - pointer to hcmCell represent the top cell
+ * @param glbNodeNames - refernce to set<string> containing all the global nodes
+ * @return pointer to the new compact netlist, owned by the caller
+ */
+hcmCompactNetlist* hcmFlattenCompact(hcmCell* topCell, set<string>& globalNodes);
+
+#endif //__COMPACT_H__
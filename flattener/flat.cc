@@ -1,6 +1,5 @@
 #include "hcm.h"
 #include <set>
-#include <fstream>
 #include <sstream>
 #include <algorithm>
 
@@ -118,6 +117,80 @@ int hcmCtx::getInstPortTopNodeHName(string ipName, string& name, set<string>& gl
   return(0);
 }
 
+/** @fn static int stitch(hcmCtx& ctx, hcmCell* fCell, hcmCell* dCell, set<string>& globalNodes)
+ * @brief given a context and the memoized flat model fCell of its master cell copy over the
+ * leaves of fCell to the flat cell dCell, renaming them by the context instead of walking the hierarchy again. 
+ * @param ctx - the current context
+ * @param fCell - pointer to hcmCell represent the flat model of the context master cell
+ * @param dCell - pointer to hcmCell represent the destination cell
+ * @param glbNodeNames - refernce to set<string> containing all the global nodes
+ * @return 0 on success, 1 otherwise
+ */
+static int stitch(hcmCtx& ctx, hcmCell* fCell, hcmCell* dCell, set<string>& globalNodes) {
+  string prefix = ctx.insts.empty() ? string("") : ctx.getHName() + string("/");
+
+  // resolve the top most name of every node of the flat model once.
+  // the nodes are created lazily so nodes without any leaf connected are not copied.
+  map<const hcmNode*, pair<string, hcmNode*> > newNodeByNode;
+  map<string, hcmNode*>::const_iterator nI;
+  for (nI = fCell->getNodes().begin(); nI != fCell->getNodes().end(); nI++) {
+    const hcmNode* node = (*nI).second;
+    string topNodeName;
+    if (node->getPort() != NULL) {
+      if (ctx.insts.empty()) {
+        topNodeName = node->getName();
+      }
+      else if (ctx.getInstPortTopNodeHName(node->getName(), topNodeName, globalNodes)) {
+        continue;
+      }
+    } 
+    else if (globalNodes.find(node->getName()) != globalNodes.end()) {
+      topNodeName = node->getName();
+    } 
+    else {
+      topNodeName = prefix + node->getName();
+    }
+    newNodeByNode[node] = make_pair(topNodeName, (hcmNode*)NULL);
+  }
+
+  map<string, hcmInstance*>::iterator iI;
+  for (iI = fCell->getInstances().begin(); iI != fCell->getInstances().end(); iI++) {
+    hcmInstance* inst = (*iI).second;
+    string hName = prefix + inst->getName();
+    hcmInstance* newInst = dCell->createInst(hName, inst->masterCell());
+    if (newInst == NULL) {
+      cerr << "-F- Could not create new instance: " << hName << " { " << inst->masterCell()->getName() << " }" << endl;
+      exit(1);
+    }
+
+    map<string, hcmInstPort*>::const_iterator ipI;
+    for (ipI = inst->getInstPorts().begin(); ipI != inst->getInstPorts().end(); ipI++) {
+      hcmInstPort* instPort = (*ipI).second;
+      map<const hcmNode*, pair<string, hcmNode*> >::iterator rI = newNodeByNode.find(instPort->getNode());
+      if (rI == newNodeByNode.end()) {
+        continue;
+      }
+
+      // now lets get the node or create it
+      hcmNode* newNode = (*rI).second.second;
+      if (newNode == NULL) {
+        const string& topNodeName = (*rI).second.first;
+        newNode = dCell->getNode(topNodeName);
+        if (newNode == NULL) {
+          newNode = dCell->createNode(topNodeName);
+          if (newNode == NULL) {
+            cerr << "-F- Could not create new node: " << topNodeName << endl;
+            exit(1);
+          }
+        }
+        (*rI).second.second = newNode;
+      }
+      dCell->connect(newInst, newNode, instPort->getPort());
+    }
+  }
+  return 0;
+}
+
 /** @fn static int flatten(hcmCtx ctx, hcmCell* sCell, hcmCell* dCell, set<string>& globalNodes)
  * @brief given a context and a given source cell sCell copy over to a flat cell dCell. 
  * @param ctx - the current context
@@ -133,9 +206,21 @@ static int flatten(hcmCtx ctx, hcmCell* sCell, hcmCell* dCell, set<string>& glob
     map<string, hcmInstance*>::iterator iI;
     for (iI = sCell->getInstances().begin(); iI != sCell->getInstances().end(); iI++) {
       hcmInstance* inst = (*iI).second;
+      hcmCell* master = inst->masterCell();
       hcmCtx instCtx = ctx;
       instCtx.insts.push_back(inst);
-      res += flatten(instCtx, inst->masterCell(), dCell, globalNodes);
+
+      // a master already flattened is stitched from its flat model
+      hcmCell* fCell = NULL;
+      if (master->getInstances().size()) {
+        fCell = master->owner()->getFlatCell(master->getName(), globalNodes);
+      }
+      if (fCell != NULL) {
+        res += stitch(instCtx, fCell, dCell, globalNodes);
+      }
+      else {
+        res += flatten(instCtx, master, dCell, globalNodes);
+      }
     }
     return 0;
   }
@@ -175,19 +260,35 @@ static int flatten(hcmCtx ctx, hcmCell* sCell, hcmCell* dCell, set<string>& glob
 }
 
 hcmCell* hcmFlatten(string flatCellName, hcmCell* sCell, set<string>& globalNodes) {
+  hcmDesign* design = sCell->owner();
+
+  // the cell may already been flattened under that name
+  hcmCell* fCell = design->getFlatCell(sCell->getName(), globalNodes);
+  if (fCell != NULL && fCell->getName() == flatCellName) {
+    return fCell;
+  }
+
   // first create the cell in same design
-  hcmCell* dCell = sCell->owner()->createCell(flatCellName);
+  hcmCell* dCell = design->createCell(flatCellName);
   if (dCell == NULL) {
     cerr << "-F- Could not create new cell: " << flatCellName << endl;
     exit(1);
   }
   
-  // copy over all ports
+  // copy over all port buses keeping their ranges, then all other ports
+  map<string, pair<int,int> >::const_iterator bI;
+  for (bI = sCell->getBuses().begin(); bI != sCell->getBuses().end(); bI++) {
+    const hcmPort* port = sCell->getPort(busNodeName((*bI).first, (*bI).second.second));
+    if (port != NULL) {
+      dCell->createBus((*bI).first, (*bI).second.first, (*bI).second.second, port->getDirection());
+    }
+  }
+
   map<string, hcmNode*>::const_iterator nI;
   for (nI = sCell->getNodes().begin(); nI != sCell->getNodes().end(); nI++) {
     const hcmNode* node = (*nI).second;
     const hcmPort* port = node->getPort();
-    if (port == NULL) {
+    if (port == NULL || dCell->getNode(node->getName()) != NULL) {
       continue;
     }
 
@@ -205,70 +306,14 @@ hcmCell* hcmFlatten(string flatCellName, hcmCell* sCell, set<string>& globalNode
   
   // empty context for the top cell.
   hcmCtx ctx; 
-  if (flatten(ctx, sCell, dCell, globalNodes)) {
+  int res = (fCell != NULL) ? stitch(ctx, fCell, dCell, globalNodes) : flatten(ctx, sCell, dCell, globalNodes);
+  if (res) {
     cerr << "-F- Could not populate new cell: " << flatCellName << endl;
     exit(1);
   }
-  return dCell;
-}
-
-int hcmWriteCellVerilog(hcmCell* topCell, string fileName) {
-  ofstream fv(fileName.c_str());
-  if (!fv.good()) {
-    cerr << "-E- Could not open file:" << fileName << endl;
-    exit(1);
-  }
-
-  fv << "module " << topCell->getName() << " (" << endl;
-  // ports list
-  vector<hcmPort*> ports = topCell->getPorts();
-  vector<hcmPort*>::iterator iP;
-  for (iP = ports.begin(); iP != ports.end(); ++iP) {
-    if (iP != ports.begin()) {
-      fv << "," << endl;
-    }
-    fv << "   " << (*iP)->owner()->getName();
-  }
-  fv << ");" << endl;
 
-  for (iP = ports.begin(); iP != ports.end(); ++iP) {
-    if ((*iP)->getDirection() == IN) {
-      fv << "   input " << (*iP)->owner()->getName() << " ;" << endl;
-    } 
-    else {
-      fv << "   output " << (*iP)->owner()->getName() << " ;" << endl;
-    }
-  }
-  fv << endl;
-
-  // go over all instances
-  map<string, hcmInstance*>::const_iterator iI;
-  for (iI = topCell->getInstances().begin(); iI != topCell->getInstances().end(); iI++) {
-    hcmInstance* inst = (*iI).second;
-
-    ostringstream is;
-    // go over all the inst ports of the original inst and find their occ nodes etc ...
-    is << "   " << inst->masterCell()->getName() << " " << inst->getName() << " (" << endl;
-    
-    map<string, hcmInstPort*>::const_iterator ipI;
-    for (ipI = inst->getInstPorts().begin(); ipI != inst->getInstPorts().end(); ipI++) {
-      hcmNode* node = (*ipI).second->getNode();
-      string nn = node->getName() ;
-      replace(nn.begin(), nn.end(), '%', '/');
-      if (ipI != inst->getInstPorts().begin()){
-	      is << "," << endl;
-      }
-      is << "      ." << (*ipI).second->getPort()->getName() << " ( " << nn << " ) ";
-    }
-    is << " ); \n" << endl;
-    string str = is.str();
-    replace( str.begin(), str.end(), '%', '/');
-    fv << str;
-  }
-
-  fv << "endmodule" << endl;
-  fv.close();
-
-  cout << "-I- Wrote " << fileName << endl;
-  return 0;
+  // memoize the flat model, a flat cell is also the flat model of itself
+  design->setFlatCell(sCell->getName(), globalNodes, dCell);
+  design->setFlatCell(flatCellName, globalNodes, dCell);
+  return dCell;
 }
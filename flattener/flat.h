@@ -7,6 +7,8 @@ using namespace std;
 
 /** @fn hcmCell* hcmFlatten(string flatCellName, hcmCell* sCell, set<string>& globalNodes)
  * @brief create a flat model cell based on the given folded model. 
+ * the flat model is memoized on the design of the source cell, instances of an already flattened
+ * cell are stitched from its flat model instead of walking its hierarchy again. 
  * @param flatCellName - the name of the new flat cell
  * @param sCell - pointer to hcmCell represent the source cell
  * @param glbNodeNames - refernce to set<string> containing all the global nodes
@@ -14,13 +16,4 @@ using namespace std;
  */
 hcmCell* hcmFlatten(string cellName, hcmCell* dCell, set<string>& globalNodes);
 
-/** @fn int hcmWriteCellVerilog(hcmCell* topCell, string fileName)
- * @brief convert a hcmCell to a verilog file format.
- * @param topCell - pointer to hcmCell represent top cell
- * @param fileName - name of the file
- * @return 0 on success.
- */
-
-int hcmWriteCellVerilog(hcmCell* topCell, string fileName);
-
 #endif //__FLAT_H__
@@ -0,0 +1,52 @@
+#ifndef __GATES_H__
+#define __GATES_H__
+#include "hcm.h"
+
+using namespace std;
+
+/*! \var typedef enum hcmGateTypes hcmGateType
+    \brief the logic function of a primitive cell of the standard cell library.
+*/
+typedef enum hcmGateTypes {
+  GATE_UNKNOWN,                         /**< Not a cell of the standard cell library.*/
+  GATE_BUFFER,                          /**< Y = A.*/
+  GATE_NOT,                             /**< Y = !A.*/
+  GATE_DFF,                             /**< Q = D on rising CLK.*/
+  GATE_OR,                              /**< Y = A | B | ... */
+  GATE_NOR,                             /**< Y = !(A | B | ...) */
+  GATE_AND,                             /**< Y = A & B & ... */
+  GATE_NAND,                            /**< Y = !(A & B & ...) */
+  GATE_XOR                              /**< Y = A ^ B.*/
+} hcmGateType;
+
+/** @fn hcmGateType hcmGetGateType(string cellName)
+ * @brief gets the logic function of a cell of the standard cell library by its name
+ * (e.g and, and2 ... and9 are all GATE_AND).
+ * @param cellName - the name of the master cell
+ * @return the type of the gate, GATE_UNKNOWN if not a cell of the library
+ */
+inline hcmGateType hcmGetGateType(string cellName) {
+  static map<string, hcmGateType> gateTypes;
+  if (gateTypes.empty()) {
+    gateTypes["buffer"] = GATE_BUFFER;
+    gateTypes["inv"] = GATE_NOT;
+    gateTypes["not"] = GATE_NOT;
+    gateTypes["dff"] = GATE_DFF;
+    gateTypes["xor2"] = GATE_XOR;
+    const char* bases[] = { "or", "nor", "and", "nand" };
+    hcmGateType types[] = { GATE_OR, GATE_NOR, GATE_AND, GATE_NAND };
+    for (int b = 0; b < 4; b++) {
+      gateTypes[bases[b]] = types[b];
+      for (char arity = '2'; arity <= '9'; arity++) {
+        gateTypes[string(bases[b]) + arity] = types[b];
+      }
+    }
+  }
+  map<string, hcmGateType>::const_iterator gI = gateTypes.find(cellName);
+  if (gI == gateTypes.end()) {
+    return(GATE_UNKNOWN);
+  }
+  return((*gI).second);
+}
+
+#endif //__GATES_H__
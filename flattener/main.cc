@@ -4,6 +4,9 @@
 #include <fstream>
 #include "hcm.h"
 #include "flat.h"
+#include "compact.h"
+#include "cleanup.h"
+#include "vlgwriter.h"
 
 using namespace std;
 
@@ -16,26 +19,40 @@ int main(int argc, char **argv) {
   int anyErr = 0;
   unsigned int i;
   vector<string> vlgFiles;
+  bool compact = false;
+  bool hier = false;
+  int cleanupPasses = CLEANUP_NONE;
   
-  if (argc < 3) {
-    anyErr++;
-  } else {
+  // the options may come before, between or after the top cell and the files
+  for (; argIdx < argc && !anyErr; argIdx++) {
     if (!strcmp(argv[argIdx], "-v")) {
-      argIdx++;
       verbose = true;
-    }
-    for (;argIdx < argc; argIdx++) {
-      vlgFiles.push_back(argv[argIdx]);
-    }
-    
-    if (vlgFiles.size() < 2) {
-      cerr << "-E- At least top-level and single verilog file required for spec model" << endl;
+    } else if (!strcmp(argv[argIdx], "-c")) {
+      compact = true;
+    } else if (!strcmp(argv[argIdx], "-h")) {
+      hier = true;
+    } else if (!strcmp(argv[argIdx], "-O") && argIdx + 1 < argc) {
+      cleanupPasses = hcmParseCleanupPasses(argv[++argIdx]);
+      if (cleanupPasses < 0) {
+        cerr << "-E- Unknown cleanup pass in: " << argv[argIdx] << endl;
+        anyErr++;
+      }
+    } else if (argv[argIdx][0] == '-') {
+      cerr << "-E- Unknown or incomplete option: " << argv[argIdx] << endl;
       anyErr++;
+    } else {
+      vlgFiles.push_back(argv[argIdx]);
     }
   }
 
+  if (!anyErr && vlgFiles.size() < 2) {
+    cerr << "-E- At least top-level and single verilog file required for spec model" << endl;
+    anyErr++;
+  }
+
   if (anyErr) {
-    cerr << "Usage: " << argv[0] << "  [-v] top-cell file1.v [file2.v] ... \n";
+    cerr << "Usage: " << argv[0] << "  [-v] [-c] [-h] [-O const,buf,dead|all] top-cell file1.v [file2.v] ... \n";
+    cerr << "  the options may come in any order\n";
     exit(1);
   }
 
@@ -58,9 +75,28 @@ int main(int argc, char **argv) {
     printf("-E- could not find cell %s\n", cellName.c_str());
     exit(1);
   }
-    
+
+  // only report the connectivity of the compact flat netlist
+  if (compact) {
+    hcmCompactNetlist* netlist = hcmFlattenCompact(topCell, globalNodes);
+    cout << "-I- Top cell flattened: " << netlist->getNumInsts() << " instances, "
+         << netlist->getNumNets() << " nets, " << netlist->getNumPins() << " pins ("
+         << netlist->getMemUsage() << " bytes)" << endl;
+    delete netlist;
+    return(0);
+  }
+
+  // write the hierarchical netlist module by module instead of flattening it
+  if (hier) {
+    hcmWriteDesignVerilog(topCell, cellName + string("_hier.v"));
+    return(0);
+  }
+
   hcmCell *flatCell = hcmFlatten(cellName + string("_flat"), topCell, globalNodes);
   cout << "-I- Top cell flattened" << endl;
+  if (cleanupPasses) {
+    hcmCleanupCell(flatCell, globalNodes, cleanupPasses);
+  }
 
   string flatVlgFileName = cellName + string("_flat.v");
   hcmWriteCellVerilog(flatCell, flatVlgFileName);
@@ -0,0 +1,239 @@
+#include "vlgwriter.h"
+#include <stdio.h>
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+// the output is flushed to the file in blocks of this size
+#define WRITER_BUF_SIZE (1 << 20)
+// number of instances formatted by one thread at a time
+#define WRITER_CHUNK_INSTS 16384
+
+/**
+ * vlgWriter - a large write buffer over a FILE, flushed only when full.
+ */
+class vlgWriter {
+  public:
+    FILE* fp;
+    string buf;
+
+    vlgWriter(FILE* fp) : fp(fp) { buf.reserve(2 * WRITER_BUF_SIZE); };
+    ~vlgWriter() { flush(); };
+    void flush() {
+      if (!buf.empty()) {
+        fwrite(buf.data(), 1, buf.size(), fp);
+        buf.clear();
+      }
+    };
+    void write(const string& str) {
+      if (buf.size() + str.size() > WRITER_BUF_SIZE) {
+        flush();
+        if (str.size() > WRITER_BUF_SIZE) {
+          fwrite(str.data(), 1, str.size(), fp);
+          return;
+        }
+      }
+      buf += str;
+    };
+};
+
+// --------------------- static functions ---------------------
+/** @fn static void appendName(string& out, const string& name)
+ * @brief append a hcm name, hierarchy separators are written as '/'.
+ */
+static void appendName(string& out, const string& name) {
+  size_t start = out.size();
+  out += name;
+  replace(out.begin() + start, out.end(), '%', '/');
+}
+
+/** @fn static void formatInsts(const vector<hcmInstance*>& insts, size_t begin, size_t end, string* out)
+ * @brief format the instances [begin, end) into \a out.
+ */
+static void formatInsts(const vector<hcmInstance*>& insts, size_t begin, size_t end, string* out) {
+  for (size_t i = begin; i < end; i++) {
+    const hcmInstance* inst = insts[i];
+    // go over all the inst ports of the original inst and find their occ nodes etc ...
+    *out += "   ";
+    appendName(*out, inst->masterCell()->getName());
+    *out += " ";
+    appendName(*out, inst->getName());
+    *out += " (\n";
+
+    map<string, hcmInstPort*>::const_iterator ipI;
+    for (ipI = inst->getInstPorts().begin(); ipI != inst->getInstPorts().end(); ipI++) {
+      if (ipI != inst->getInstPorts().begin()) {
+        *out += ",\n";
+      }
+      *out += "      .";
+      appendName(*out, (*ipI).second->getPort()->getName());
+      *out += " ( ";
+      appendName(*out, (*ipI).second->getNode()->getName());
+      *out += " ) ";
+    }
+    *out += " ); \n\n";
+  }
+}
+
+/** @fn static void writeModule(vlgWriter& w, hcmCell* cell, int numThreads)
+ * @brief write one cell as a verilog module, the bits of a bus are declared as one vector.
+ */
+static void writeModule(vlgWriter& w, hcmCell* cell, int numThreads) {
+  string head;
+  head += "module ";
+  appendName(head, cell->getName());
+  head += " (\n";
+
+  // the bus each bit node belongs to
+  map<string, string> bitBus;
+  const map< string, pair<int,int> >& buses = cell->getBuses();
+  map< string, pair<int,int> >::const_iterator bI;
+  for (bI = buses.begin(); bI != buses.end(); bI++) {
+    int low = min((*bI).second.first, (*bI).second.second);
+    int high = max((*bI).second.first, (*bI).second.second);
+    for (int b = low; b <= high; b++) {
+      bitBus[(*bI).first + "[" + to_string(b) + "]"] = (*bI).first;
+    }
+  }
+
+  // ports list
+  vector<hcmPort*> ports = cell->getPorts();
+  vector<string> portNames;
+  vector<hcmPortDir> portDirs;
+  set<string> portBuses;
+  for (size_t p = 0; p < ports.size(); p++) {
+    const string& name = ports[p]->owner()->getName();
+    map<string, string>::const_iterator bbI = bitBus.find(name);
+    if (bbI == bitBus.end()) {
+      portNames.push_back(name);
+    }
+    else if (portBuses.insert((*bbI).second).second) {
+      portNames.push_back((*bbI).second);
+    }
+    else {
+      continue;
+    }
+    portDirs.push_back(ports[p]->getDirection());
+  }
+  for (size_t p = 0; p < portNames.size(); p++) {
+    if (p) {
+      head += ",\n";
+    }
+    head += "   ";
+    appendName(head, portNames[p]);
+  }
+  head += ");\n";
+
+  for (size_t p = 0; p < portNames.size(); p++) {
+    head += (portDirs[p] == IN) ? "   input " : "   output ";
+    bI = buses.find(portNames[p]);
+    if (bI != buses.end() && portBuses.count(portNames[p])) {
+      head += "[" + to_string((*bI).second.first) + ":" + to_string((*bI).second.second) + "] ";
+    }
+    appendName(head, portNames[p]);
+    head += " ;\n";
+  }
+  for (bI = buses.begin(); bI != buses.end(); bI++) {
+    if (portBuses.count((*bI).first)) {
+      continue;
+    }
+    head += "   wire [" + to_string((*bI).second.first) + ":" + to_string((*bI).second.second) + "] ";
+    appendName(head, (*bI).first);
+    head += " ;\n";
+  }
+  head += "\n";
+  w.write(head);
+
+  // go over all instances, large cells are formatted by several threads chunk by chunk
+  vector<hcmInstance*> insts;
+  insts.reserve(cell->getInstances().size());
+  map<string, hcmInstance*>::const_iterator iI;
+  for (iI = cell->getInstances().begin(); iI != cell->getInstances().end(); iI++) {
+    insts.push_back((*iI).second);
+  }
+  if (numThreads <= 0) {
+    numThreads = max(1u, thread::hardware_concurrency());
+  }
+  vector<string> chunks(numThreads);
+  for (size_t begin = 0; begin < insts.size(); begin += numThreads * WRITER_CHUNK_INSTS) {
+    vector<thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+      chunks[t].clear();
+    }
+    for (int t = 1; t < numThreads; t++) {
+      size_t cBegin = min(insts.size(), begin + t * WRITER_CHUNK_INSTS);
+      size_t cEnd = min(insts.size(), cBegin + WRITER_CHUNK_INSTS);
+      if (cBegin == cEnd) {
+        break;
+      }
+      threads.push_back(thread(formatInsts, cref(insts), cBegin, cEnd, &chunks[t]));
+    }
+    // the first chunk is formatted by the calling thread
+    formatInsts(insts, begin, min(insts.size(), begin + WRITER_CHUNK_INSTS), &chunks[0]);
+    for (size_t t = 0; t < threads.size(); t++) {
+      threads[t].join();
+    }
+    for (int t = 0; t < numThreads; t++) {
+      w.write(chunks[t]);
+    }
+  }
+
+  w.write("endmodule\n");
+}
+
+/** @fn static void collectModules(hcmCell* cell, set<hcmCell*>& visited, vector<hcmCell*>& order)
+ * @brief collect the cells with instances below \a cell, each after the cells it instantiates.
+ */
+static void collectModules(hcmCell* cell, set<hcmCell*>& visited, vector<hcmCell*>& order) {
+  if (!visited.insert(cell).second || cell->getInstances().empty()) {
+    return;
+  }
+  map<string, hcmInstance*>::const_iterator iI;
+  for (iI = cell->getInstances().begin(); iI != cell->getInstances().end(); iI++) {
+    collectModules((*iI).second->masterCell(), visited, order);
+  }
+  order.push_back(cell);
+}
+// --------------------- static functions ---------------------
+
+int hcmWriteCellVerilog(hcmCell* topCell, string fileName, int numThreads) {
+  FILE* fp = fopen(fileName.c_str(), "w");
+  if (!fp) {
+    cerr << "-E- Could not open file:" << fileName << endl;
+    exit(1);
+  }
+  {
+    vlgWriter w(fp);
+    writeModule(w, topCell, numThreads);
+  }
+  fclose(fp);
+
+  cout << "-I- Wrote " << fileName << endl;
+  return 0;
+}
+
+int hcmWriteDesignVerilog(hcmCell* topCell, string fileName, int numThreads) {
+  FILE* fp = fopen(fileName.c_str(), "w");
+  if (!fp) {
+    cerr << "-E- Could not open file:" << fileName << endl;
+    exit(1);
+  }
+
+  set<hcmCell*> visited;
+  vector<hcmCell*> order;
+  collectModules(topCell, visited, order);
+  {
+    vlgWriter w(fp);
+    for (size_t m = 0; m < order.size(); m++) {
+      if (m) {
+        w.write("\n");
+      }
+      writeModule(w, order[m], numThreads);
+    }
+  }
+  fclose(fp);
+
+  cout << "-I- Wrote " << fileName << " (" << order.size() << " modules)" << endl;
+  return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef __VLGWRITER_H__
+#define __VLGWRITER_H__
+#include "hcm.h"
+
+using namespace std;
+
+/** @fn int hcmWriteCellVerilog(hcmCell* topCell, string fileName, int numThreads = 0)
+ * @brief convert a hcmCell to a verilog file format.
+ * the text is formatted into large buffers written without flushing per line, the instances
+ * of large cells are formatted in parallel chunks and written in order.
+ * @param topCell - pointer to hcmCell represent top cell
+ * @param fileName - name of the file
+ * @param numThreads - number of formatting threads, 0 for the number of cpus
+ * @return 0 on success.
+ */
+int hcmWriteCellVerilog(hcmCell* topCell, string fileName, int numThreads = 0);
+
+/** @fn int hcmWriteDesignVerilog(hcmCell* topCell, string fileName, int numThreads = 0)
+ * @brief convert a hierarchical hcmCell to a verilog file format, module by module.
+ * every cell with instances below \a topCell is written once, before the cells instantiating it.
+ * leaf cells (e.g the standard cell library) are not written.
+ * @param topCell - pointer to hcmCell represent top cell
+ * @param fileName - name of the file
+ * @param numThreads - number of formatting threads, 0 for the number of cpus
+ * @return 0 on success.
+ */
+int hcmWriteDesignVerilog(hcmCell* topCell, string fileName, int numThreads = 0);
+
+#endif //__VLGWRITER_H__
@@ -1,7 +1,16 @@
+#ifndef HCMVCD_H
+#define HCMVCD_H
+
 #include "hcm.h"
-#include <fstream>
+#include <stdio.h>
+#include <sstream>
 #include <list>
 #include <set>
+#include <vector>
+#include <limits.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 using namespace std;
 
@@ -73,27 +82,148 @@ class cmpNodeCtx {
     };
 };
 
+// default size of the ring buffer between the formatter and the writer thread
+#define VCD_RING_SIZE (4 << 20)
+// the formatter hands its text to the ring in blocks of this size
+#define VCD_BLOCK_SIZE (64 << 10)
+
+/**
+ * vcdRingWriter class writes a file from a dedicated thread.
+ * the caller copies formatted text into an in-memory ring buffer and only blocks when the ring is full,
+ * the writer thread drains the ring with large sequential writes.
+ * vcdRingWriter is a mutable object.
+ */
+class vcdRingWriter {
+  private:
+    FILE* fp;
+    vector<char> ring;
+    // head / tail - the total number of bytes put into / taken out of the ring
+    size_t head;
+    size_t tail;
+    bool done;
+    mutex lock;
+    condition_variable notEmpty;
+    condition_variable notFull;
+    thread writer;
+
+    // statistics
+    size_t highWater;
+    double stallTime;
+
+    /** @fn void run()
+     * @brief the writer thread loop, writes the ring content until closed and drained.
+     */
+    void run();
+
+  public:
+    /** @fn vcdRingWriter(string fileName, size_t ringSize)
+     * @brief open the file and start the writer thread.
+     */
+    vcdRingWriter(string fileName, size_t ringSize = VCD_RING_SIZE);
+
+    /** @fn ~vcdRingWriter()
+     * @brief write out all the buffered text, stop the writer thread and close the file.
+     */
+    ~vcdRingWriter();
+
+    bool good() const { return(fp != NULL); };
+
+    /** @fn void write(const char* data, size_t len)
+     * @brief copy the text to the ring, blocking while the ring is full.
+     */
+    void write(const char* data, size_t len);
+
+    /** @fn void close()
+     * @brief write out all the buffered text, stop the writer thread and close the file.
+     */
+    void close();
+
+    size_t getRingSize() const { return(ring.size()); };
+    size_t getBytesWritten() const { return(tail); };
+    size_t getHighWater() const { return(highWater); };
+    double getStallTime() const { return(stallTime); };
+};
+
+class hcmWaveWriter;
+
+/**
+ * vcdDumpControl class selects the signals and the time window to dump.
+ * a node is dumped if its hierarchical name (i.e a/b/n) matches one of the globs, is below one of the
+ * scopes or is in the fanin cone of one of the cone outputs. with all lists empty the default
+ * selection of vcdFormatter is used. changes are written only from startTime up to stopTime.
+ * vcdDumpControl is a mutable object.
+ */
+class vcdDumpControl {
+  public:
+    vector<string> signalGlobs;
+    vector<string> scopes;
+    // names of top cell nodes, the cone is traced through the instances of the top cell
+    vector<string> coneOutputs;
+    unsigned long startTime;
+    unsigned long stopTime;
+
+    vcdDumpControl() : startTime(0), stopTime(ULONG_MAX) {};
+
+    /** @fn bool selectsSignals() const
+     * @brief true if any of the signal selection lists is given.
+     */
+    bool selectsSignals() const { return(!signalGlobs.empty() || !scopes.empty() || !coneOutputs.empty()); };
+
+    /** @fn int parseWindow(string window)
+     * @brief set the time window from a string of the form start:stop, either may be omitted.
+     * @return 0 on success, 1 otherwise
+     */
+    int parseWindow(string window);
+};
+
+// buses wider than this are dumped bit by bit
+#define VCD_MAX_BUS_WIDTH 64
+
 /**
  * vcdFormatter class will genarte and mange the vcd file.
  * NOTE: the created VCD only contains top level nodes for nodes that are external to an instance. 
+ * the bits of a bus of the cell are dumped as a single vector signal.
  * vcdFormatter is a mutable object.
  */
 class vcdFormatter {
   private:
-    // Output stream class to operate on.
-    ofstream vcd;
+    // the writer of the file and the text formatted since the last block was handed to it
+    vcdRingWriter* out;
+    string buf;
+    // the header is formatted here while the signals are registered
+    ostringstream hdr;
+    // the writer of the binary wave file, NULL when writing VCD
+    hcmWaveWriter* wave;
     // true if the parser is OK, false otherwise
     bool is_good;
-    // codeByNodeCtx - container of tuples of type (const hcmNodeCtx, string) - 
+    // handleByNodeCtx - container of tuples of type (const hcmNodeCtx, int) - 
     // for each tuple, the hcmNodeCtx repersent the contex of the node,
-    // and the string is a VCDId representation of the hcmNodeCtx.
-    map<const hcmNodeCtx, string, cmpNodeCtx> codeByNodeCtx;
+    // and the int is the handle of the bit dumped for it.
+    map<const hcmNodeCtx, int, cmpNodeCtx> handleByNodeCtx;
+    // per bit handle - the last value given (-1 if none yet), the signal holding it and its position
+    // in the signal value
+    vector<signed char> values;
+    vector<int> bitSignal;
+    vector<int> bitPos;
+    // per signal - the VCDId code, the current value and the last value written, most significant bit first
+    vector<string> codes;
+    vector<string> sigValues;
+    vector<string> sigWritten;
+    // the signals changed since the last time change
+    vector<char> sigDirty;
+    vector<int> dirtySignals;
     // const pointer to hcmCell of the topCell to parse
     const hcmCell* topCell;
     // container for the global nodes
     set<string> glbNodeNames;
     // debug mode - true print all inside nodes, false - print only input / output to vcd file
     bool debug_mode;
+    // the signals and times to dump and the nodes of the top cell in the selected fanin cones
+    vcdDumpControl control;
+    set<const hcmNode*> coneNodes;
+    // the time of the changes given and whether the dump window was entered
+    unsigned long curTime;
+    bool windowOpen;
 
     /** @fn int dfsVCDScope(list<const hcmInstance*>& parentInsts)
      * @brief recursive function to print the wires and module definitions to the vcd file
@@ -101,13 +231,32 @@ class vcdFormatter {
      * @return 0 on success
      */
     int dfsVCDScope(list<const hcmInstance*>& parentInsts);
-    
-    /** @fn string getVCDId(int id)
-     * @brief get the string of the VCD code based on an integer 
-     * @param id - the integer id
-     * @return string of the VCD code based on an integer 
+
+    /** @fn void traceCones()
+     * @brief collect the nodes of the top cell in the fanin cones of the cone outputs.
+     */
+    void traceCones();
+
+    /** @fn bool isSelected(list<const hcmInstance*>& parentInsts, const hcmNode* node)
+     * @brief check if the dump control selects the node in the given context.
+     */
+    bool isSelected(list<const hcmInstance*>& parentInsts, const hcmNode* node);
+
+    /** @fn int addSignal(string name, int width, string range)
+     * @brief declare a new signal in the header, its bit handles should be added right after.
+     * @return the index of the signal
+     */
+    int addSignal(string name, int width, string range);
+
+    /** @fn void addBit(list<const hcmInstance*>& parentInsts, const hcmNode* node, int pos)
+     * @brief bind the node to the given bit of the last added signal.
+     */
+    void addBit(list<const hcmInstance*>& parentInsts, const hcmNode* node, int pos);
+
+    /** @fn void flushChanges()
+     * @brief write the signals changed at the current time.
      */
-    string getVCDId(int id);
+    void flushChanges();
 
     /** @fn int genVCDHeader()
      * @brief create the vcd header file 
@@ -122,9 +271,19 @@ class vcdFormatter {
      * @param cell - const hcmCell* of the top cell
      * @param glbNodeNames - refernce to set<string> containing all the global nodes
      * @param debug_mode - true print all inside nodes, false - print only input / output
+     * @param binary - write the same signals and changes as an hcm wave (.hwv) file instead of VCD
+     * @param control - the signals and time window to dump, NULL for all the ports (or nodes in debug mode)
      * @return none
      */
-    vcdFormatter(string fileName, const hcmCell* cell, set<string>& glbNodeNames_, bool debug_mode_ = false);
+    vcdFormatter(string fileName, const hcmCell* cell, set<string>& glbNodeNames_, bool debug_mode_ = false,
+                 bool binary = false, const vcdDumpControl* control_ = NULL);
+
+    /** @fn static string getVCDId(int id)
+     * @brief get the string of the VCD code based on an integer 
+     * @param id - the integer id
+     * @return string of the VCD code based on an integer 
+     */
+    static string getVCDId(int id);
 
     /** @fn ~vcdFormatter()
      * @brief destructor of vcdFormatter
@@ -145,11 +304,60 @@ class vcdFormatter {
      */
     int changeTime(unsigned long int newTime);
 
+    /** @fn int getHandle(const hcmNodeCtx* nodeCtx)
+     * @brief gets the handle of the bit dumped for the node context, to be used with changeValue.
+     * handles are assigned once when the header is written and are dense from 0.
+     * the bits of a bus have a handle each and are written together as one vector signal.
+     * @param nodeCtx - const pointer to hcmNodeCtx representing a wire
+     * @return the handle, -1 if the node is not dumped
+     */
+    int getHandle(const hcmNodeCtx* nodeCtx);
+
+    /** @fn int getNumHandles() const
+     * @brief gets the number of dumped bits.
+     */
+    int getNumHandles() const { return(values.size()); };
+
+    /** @fn int changeValue(int handle, bool value)
+     * @brief add indication to the vcd file of a change value to the bit with the given handle.
+     * the changes are written on the next time change, nothing is written for a signal whose
+     * value is the same as the last value written for it.
+     * @param handle - the handle of the signal, ignored if negative
+     * @param value - new value of the wire
+     * @return 0 on success
+     */
+    int changeValue(int handle, bool value) {
+      if (handle < 0 || values[handle] == (signed char)value) {
+        return(0);
+      }
+      values[handle] = value;
+      int sig = bitSignal[handle];
+      sigValues[sig][bitPos[handle]] = (value ? '1' : '0');
+      if (!sigDirty[sig]) {
+        sigDirty[sig] = 1;
+        dirtySignals.push_back(sig);
+      }
+      return(0);
+    };
+
     /** @fn int changeValue(const hcmNodeCtx* nodeCtx, bool value)
      * @brief add indication to the vcd file of a change value to a wire represented by nodeCtx 
-     * @param nodeCtx - const pointer to hcmNodeCtx representing a wire
+     * @param nodeCtx - const pointer to hcmNodeCtx representing a wire, ignored if it is not dumped
      * @param value - new value of the wire
-     * @return 0 on success, 1 otherwise
+     * @return 0 on success
      */
     int changeValue(const hcmNodeCtx *nodeCtx, bool value);
-};
\ No newline at end of file
+
+    /** @fn void close()
+     * @brief write out all the pending changes and close the file, called by the destructor if needed.
+     */
+    void close();
+
+    /** @fn void printWriterStats(ostream& os) const
+     * @brief print the bytes written, the ring buffer high-water mark and the time the simulation
+     * was stalled on a full ring. valid after close().
+     */
+    void printWriterStats(ostream& os) const;
+};
+
+#endif // HCMVCD_H
@@ -0,0 +1,226 @@
+#ifndef HCMWAVE_H
+#define HCMWAVE_H
+
+#include "hcmvcd.h"
+#include <stdint.h>
+
+using namespace std;
+
+// the first bytes of every hcm wave (.hwv) file and the last bytes of its index
+#define HWV_MAGIC "HCMWAVE2"
+#define HWV_INDEX_MAGIC "HWVINDEX"
+// a block is closed at the first time change after its change streams reach this size
+#define HWV_BLOCK_SIZE (256 << 10)
+
+/**
+ * hcm wave (.hwv) file layout, all fixed size integers are little endian:
+ *   header - HWV_MAGIC, u32 raw size, u32 compressed size, zlib compressed signal table
+ *   blocks - u64 first time, u64 last time, u32 raw size, u32 compressed size, zlib compressed data
+ *   index  - per block: u64 first time, u64 last time, u64 file offset
+ *   footer - u64 number of blocks, u64 index offset, u64 final time, HWV_INDEX_MAGIC
+ * the signal table is the scope tree as a list of records: 'S' scope name, 'V' width name, 'U'.
+ * a block holds the values of all signals at its first time, each a known flag followed by the
+ * value if known, then a value change stream for every signal that changed in it. times in a stream are deltas from the previous change.
+ * a file with no footer (an interrupted run) is read by walking the block headers.
+ */
+
+/**
+ * hcmWaveScopeRec - a record of the signal table of a wave file.
+ */
+struct hcmWaveScopeRec {
+  // 'S' - enter scope, 'V' - a signal, 'U' - leave scope
+  char type;
+  string name;
+  // for 'V' records - the signal handle and its width in bits
+  int handle;
+  unsigned width;
+};
+
+/**
+ * hcmWaveChange - a value change of a signal read from a wave file.
+ */
+struct hcmWaveChange {
+  unsigned long time;
+  int handle;
+  uint64_t value;
+};
+
+/**
+ * hcmWaveBlockInfo - the time range of a block and where it is in the file.
+ */
+struct hcmWaveBlockInfo {
+  unsigned long startTime;
+  unsigned long endTime;
+  uint64_t offset;
+};
+
+/**
+ * hcmWaveWriter class writes a wave file with the same signals and changes a vcdFormatter
+ * would write to a VCD file. signals are declared first, then the changes are recorded in time order.
+ * the file is written through a vcdRingWriter so the compression is the only cost to the caller.
+ * hcmWaveWriter is a mutable object.
+ */
+class hcmWaveWriter {
+  private:
+    vcdRingWriter* out;
+    bool is_good;
+    // the encoded signal table, written when the first change arrives
+    string sigTable;
+    bool headerDone;
+    vector<unsigned> widths;
+    // per signal - the current value and the value when the current block started, a signal
+    // is unknown until its first change so any 64 bit value is a valid value
+    vector<uint64_t> values;
+    vector<uint64_t> blockValues;
+    vector<char> known;
+    vector<char> blockKnown;
+    // per signal - the change stream in the current block and the time of its last change
+    vector<string> streams;
+    vector<unsigned long> lastTime;
+    vector<unsigned> numChanges;
+    // the signals with a non empty stream in the current block
+    vector<int> changed;
+    size_t blockBytes;
+    unsigned long curTime;
+    unsigned long blockStart;
+    vector<hcmWaveBlockInfo> index;
+    uint64_t fileBytes;
+    uint64_t rawBytes;
+
+    /** @fn void writeRaw(const string& data)
+     * @brief write bytes to the file keeping track of the offset.
+     */
+    void writeRaw(const string& data);
+
+    /** @fn void writeHeader()
+     * @brief write the magic and the signal table once.
+     */
+    void writeHeader();
+
+    /** @fn void flushBlock()
+     * @brief encode, compress and write the current block and start a new one at the current time.
+     */
+    void flushBlock();
+
+  public:
+    /** @fn hcmWaveWriter(string fileName)
+     * @brief open the wave file, signals should be declared before the first change.
+     */
+    hcmWaveWriter(string fileName);
+
+    /** @fn ~hcmWaveWriter()
+     * @brief close the file if not closed yet.
+     */
+    ~hcmWaveWriter();
+
+    bool good() const { return(is_good); };
+
+    /** @fn void pushScope(string name)
+     * @brief enter a new scope, following signals belong to it.
+     */
+    void pushScope(string name);
+
+    /** @fn void popScope()
+     * @brief leave the current scope.
+     */
+    void popScope();
+
+    /** @fn int addSignal(string name, unsigned width)
+     * @brief declare a signal in the current scope.
+     * @return the handle of the signal, handles are dense from 0 in declaration order
+     */
+    int addSignal(string name, unsigned width = 1);
+
+    /** @fn void changeTime(unsigned long newTime)
+     * @brief following changes happen at \a newTime, may close the current block.
+     */
+    void changeTime(unsigned long newTime);
+
+    /** @fn void changeValue(int handle, uint64_t value)
+     * @brief record a new value of the signal at the current time.
+     */
+    void changeValue(int handle, uint64_t value);
+
+    /** @fn void close()
+     * @brief write the last block, the index and the footer and close the file.
+     */
+    void close();
+
+    uint64_t getFileBytes() const { return(fileBytes); };
+    uint64_t getRawBytes() const { return(rawBytes); };
+    size_t getNumBlocks() const { return(index.size()); };
+};
+
+/**
+ * hcmWaveReader class reads a wave file one block at a time, so files of any size can be read
+ * in the memory of a single block. the index allows reading the values at any time without
+ * reading the blocks before it.
+ * hcmWaveReader is a mutable object.
+ */
+class hcmWaveReader {
+  private:
+    FILE* fp;
+    bool is_good;
+    vector<hcmWaveScopeRec> scopeRecs;
+    // per signal - its name including the scopes (i.e DUT.a) and width
+    vector<string> names;
+    vector<unsigned> widths;
+    vector<hcmWaveBlockInfo> blocks;
+    unsigned long endTime;
+    uint64_t fileBytes;
+
+    /** @fn int readHeader()
+     * @brief read the signal table.
+     * @return 0 on success
+     */
+    int readHeader();
+
+    /** @fn int readIndex()
+     * @brief read the index from the footer, or build it from the block headers if there is no footer.
+     * @return 0 on success
+     */
+    int readIndex();
+
+  public:
+    /** @fn hcmWaveReader(string fileName)
+     * @brief open the wave file and read its signal table and index.
+     */
+    hcmWaveReader(string fileName);
+
+    ~hcmWaveReader();
+
+    bool good() const { return(is_good); };
+
+    const vector<hcmWaveScopeRec>& getScopeRecs() const { return(scopeRecs); };
+    int getNumSignals() const { return(names.size()); };
+    const string& getSignalName(int handle) const { return(names[handle]); };
+    unsigned getSignalWidth(int handle) const { return(widths[handle]); };
+    int getNumBlocks() const { return(blocks.size()); };
+    const hcmWaveBlockInfo& getBlockInfo(int block) const { return(blocks[block]); };
+    unsigned long getEndTime() const { return(endTime); };
+    uint64_t getFileBytes() const { return(fileBytes); };
+
+    /** @fn int findBlock(unsigned long time) const
+     * @brief gets the block holding the given time.
+     * @return the index of the last block starting at or before \a time, -1 if there are no blocks
+     */
+    int findBlock(unsigned long time) const;
+
+    /** @fn int readBlock(int block, vector<uint64_t>& startValues, vector<char>& startKnown, vector<hcmWaveChange>& changes)
+     * @brief read and decode a block.
+     * @param startValues - set to the values of all signals when the block starts
+     * @param startKnown - set per signal to whether it has a value when the block starts
+     * @param changes - set to the changes in the block ordered by time
+     * @return 0 on success
+     */
+    int readBlock(int block, vector<uint64_t>& startValues, vector<char>& startKnown, vector<hcmWaveChange>& changes);
+
+    /** @fn int getValues(unsigned long time, vector<uint64_t>& values, vector<char>& known)
+     * @brief gets the values of all signals at the given time, reading only the block holding it.
+     * @param known - set per signal to whether it has a value at that time
+     * @return 0 on success
+     */
+    int getValues(unsigned long time, vector<uint64_t>& values, vector<char>& known);
+};
+
+#endif // HCMWAVE_H
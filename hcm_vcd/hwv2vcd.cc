@@ -0,0 +1,99 @@
+#include <string.h>
+#include <time.h>
+#include "hcmwave.h"
+
+using namespace std;
+
+// --------------------- static functions ---------------------
+/** @fn static void formatValue(string& buf, uint64_t value, unsigned width, const string& code)
+ * @brief append a VCD value change line for a signal.
+ */
+static void formatValue(string& buf, uint64_t value, unsigned width, const string& code) {
+  if (width == 1) {
+    buf += (value ? '1' : '0');
+  } else {
+    // leading zeros are implied
+    buf += 'b';
+    int b = width - 1;
+    while (b > 0 && !((value >> b) & 1)) {
+      b--;
+    }
+    for (; b >= 0; b--) {
+      buf += ((value >> b) & 1) ? '1' : '0';
+    }
+    buf += ' ';
+  }
+  buf += code;
+  buf += '\n';
+}
+// --------------------- static functions ---------------------
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    cerr << "Usage: " << argv[0] << " file.hwv file.vcd" << endl;
+    exit(1);
+  }
+
+  hcmWaveReader wave(argv[1]);
+  if (!wave.good()) {
+    exit(1);
+  }
+  vcdRingWriter out(argv[2]);
+  if (!out.good()) {
+    cerr << "-E- Could not open: " << argv[2] << endl;
+    exit(1);
+  }
+
+  vector<string> codes;
+  for (int h = 0; h < wave.getNumSignals(); h++) {
+    codes.push_back(vcdFormatter::getVCDId(h + 1));
+  }
+
+  time_t rawtime;
+  time(&rawtime);
+  string buf;
+  buf += string("$date\n     ") + ctime(&rawtime) + "\n$end\n";
+  buf += string("$version\n     Converted from hcm wave file: ") + argv[1] + "\n$end\n";
+  buf += "$timescale\n     1s\n$end\n";
+  const vector<hcmWaveScopeRec>& recs = wave.getScopeRecs();
+  for (size_t r = 0; r < recs.size(); r++) {
+    if (recs[r].type == 'S') {
+      buf += "$scope module " + recs[r].name + " $end\n";
+    } else if (recs[r].type == 'V') {
+      buf += "$var wire " + to_string(recs[r].width) + " " + codes[recs[r].handle] + " " + recs[r].name + " $end\n";
+    } else {
+      buf += "$upscope $end\n";
+    }
+  }
+  buf += "$enddefinitions $end\n#0\n$dumpvars\n";
+
+  // stream the blocks, a block is the only part of the file held in memory
+  unsigned long lastTime = 0;
+  vector<uint64_t> startValues;
+  vector<char> startKnown;
+  vector<hcmWaveChange> changes;
+  for (int b = 0; b < wave.getNumBlocks(); b++) {
+    if (wave.readBlock(b, startValues, startKnown, changes)) {
+      cerr << "-E- Could not read block " << b << " of " << argv[1] << endl;
+      exit(1);
+    }
+    for (size_t c = 0; c < changes.size(); c++) {
+      const hcmWaveChange& change = changes[c];
+      if (change.time != lastTime) {
+        buf += "#" + to_string(change.time) + "\n";
+        lastTime = change.time;
+      }
+      formatValue(buf, change.value, wave.getSignalWidth(change.handle), codes[change.handle]);
+    }
+    if (buf.size() >= VCD_BLOCK_SIZE) {
+      out.write(buf.data(), buf.size());
+      buf.clear();
+    }
+  }
+  if (wave.getEndTime() != lastTime) {
+    buf += "#" + to_string(wave.getEndTime()) + "\n";
+  }
+  out.write(buf.data(), buf.size());
+  out.close();
+  return(0);
+}
@@ -0,0 +1,113 @@
+#include <string.h>
+#include <stdlib.h>
+#include <fnmatch.h>
+#include "hcmwave.h"
+
+using namespace std;
+
+// --------------------- static functions ---------------------
+/** @fn static string valueStr(uint64_t value, bool known, unsigned width)
+ * @brief gets the binary string of a value, x if unknown.
+ */
+static string valueStr(uint64_t value, bool known, unsigned width) {
+  string res;
+  for (int b = width - 1; b >= 0; b--) {
+    res += !known ? 'x' : (((value >> b) & 1) ? '1' : '0');
+  }
+  return(res);
+}
+// --------------------- static functions ---------------------
+
+int main(int argc, char** argv) {
+  int argIdx = 1;
+  int anyErr = 0;
+  bool list = false;
+  bool atTime = false;
+  bool inRange = false;
+  unsigned long from = 0;
+  unsigned long to = 0;
+  vector<char*> args;
+
+  // the options may come before or after the file and the globs
+  for (; argIdx < argc && !anyErr; argIdx++) {
+    if (!strcmp(argv[argIdx], "-l")) {
+      list = true;
+    } else if (!strcmp(argv[argIdx], "-t") && argIdx + 1 < argc) {
+      atTime = true;
+      from = strtoul(argv[++argIdx], NULL, 10);
+    } else if (!strcmp(argv[argIdx], "-r") && argIdx + 2 < argc) {
+      inRange = true;
+      from = strtoul(argv[++argIdx], NULL, 10);
+      to = strtoul(argv[++argIdx], NULL, 10);
+    } else if (argv[argIdx][0] == '-') {
+      cerr << "-E- Unknown or incomplete option: " << argv[argIdx] << endl;
+      anyErr++;
+    } else {
+      args.push_back(argv[argIdx]);
+    }
+  }
+  if (args.empty() || anyErr) {
+    cerr << "Usage: " << argv[0] << " [-l] [-t time] [-r from to] file.hwv [signal-glob] ..." << endl;
+    exit(1);
+  }
+
+  hcmWaveReader wave(args[0]);
+  if (!wave.good()) {
+    exit(1);
+  }
+
+  // the signals matching any of the given globs, all signals if none given
+  vector<bool> selected(wave.getNumSignals(), args.size() == 1);
+  for (int h = 0; h < wave.getNumSignals(); h++) {
+    for (size_t g = 1; g < args.size(); g++) {
+      if (!fnmatch(args[g], wave.getSignalName(h).c_str(), 0)) {
+        selected[h] = true;
+      }
+    }
+  }
+
+  if (list) {
+    for (int h = 0; h < wave.getNumSignals(); h++) {
+      if (selected[h]) {
+        cout << wave.getSignalName(h) << " " << wave.getSignalWidth(h) << endl;
+      }
+    }
+  } else if (atTime) {
+    vector<uint64_t> values;
+    vector<char> known;
+    if (wave.getValues(from, values, known)) {
+      cerr << "-E- Could not read the values at time " << from << endl;
+      exit(1);
+    }
+    for (int h = 0; h < wave.getNumSignals(); h++) {
+      if (selected[h]) {
+        cout << wave.getSignalName(h) << " " << valueStr(values[h], known[h], wave.getSignalWidth(h)) << endl;
+      }
+    }
+  } else if (inRange) {
+    vector<uint64_t> startValues;
+    vector<char> startKnown;
+    vector<hcmWaveChange> changes;
+    int b = wave.findBlock(from);
+    for (; b >= 0 && b < wave.getNumBlocks() && wave.getBlockInfo(b).startTime <= to; b++) {
+      if (wave.readBlock(b, startValues, startKnown, changes)) {
+        cerr << "-E- Could not read block " << b << endl;
+        exit(1);
+      }
+      for (size_t c = 0; c < changes.size(); c++) {
+        const hcmWaveChange& change = changes[c];
+        if (change.time < from || change.time > to || !selected[change.handle]) {
+          continue;
+        }
+        cout << "#" << change.time << " " << wave.getSignalName(change.handle) << " "
+             << valueStr(change.value, true, wave.getSignalWidth(change.handle)) << endl;
+      }
+    }
+  } else {
+    cout << "-I- Signals: " << wave.getNumSignals() << endl;
+    cout << "-I- Blocks: " << wave.getNumBlocks() << endl;
+    cout << "-I- Time: 0 to " << wave.getEndTime() << endl;
+    cout << "-I- File size: " << wave.getFileBytes() << " bytes" << endl;
+  }
+  return(0);
+}
@@ -1,8 +1,13 @@
 #include <errno.h>
+#include <stdlib.h>
 #include <signal.h>
 #include <sstream>
 #include <algorithm>
+#include <string.h>
+#include <chrono>
+#include <fnmatch.h>
 #include "hcmvcd.h"
+#include "hcmwave.h"
 
 using namespace std;
 
@@ -56,15 +61,19 @@ int vcdFormatter::dfsVCDScope(list<const hcmInstance*>& parentInsts) {
 
   // top level is named DUT
   if (inst) {
-    vcd << "$scope module " << inst->getName() << " $end" << endl;
+    hdr << "$scope module " << inst->getName() << " $end\n";
     cell = inst->masterCell();
   } 
   else {
-    vcd << "$scope module DUT $end" << endl;
+    hdr << "$scope module DUT $end\n";
     cell = topCell;
   }
+  if (wave) {
+    wave->pushScope(inst ? inst->getName() : string("DUT"));
+  }
 
   // dump out all local nodes in this level that are not external
+  set<const hcmNode*> dumped;
   map<string, hcmNode*>::const_iterator nI;
   const map<string, hcmNode*>& nodesMap = cell->getNodes();
   for (nI = nodesMap.begin(); nI != nodesMap.end(); nI++) {
@@ -76,18 +85,44 @@ int vcdFormatter::dfsVCDScope(list<const hcmInstance*>& parentInsts) {
     if (glbNodeNames.find(name) != glbNodeNames.end()) {
       continue;
     }
-    
-    if (debug_mode) {
-      string code = getVCDId(codeByNodeCtx.size()+1);
-      hcmNodeCtx nodeCtx(parentInsts, node);
-      codeByNodeCtx[nodeCtx] = code;
-      vcd << "$var wire 1 " << code << " " << name << " $end" << endl;
+    if (isSelected(parentInsts, node)) {
+      dumped.insert(node);
+    }
+  }
+
+  // buses with all their bits dumped become one vector signal, from the left index of the range
+  map<string, pair<int,int> >::const_iterator bI;
+  for (bI = cell->getBuses().begin(); bI != cell->getBuses().end(); bI++) {
+    int from = (*bI).second.first;
+    int to = (*bI).second.second;
+    int step = (from > to) ? -1 : 1;
+    int width = abs(from - to) + 1;
+    if (width > VCD_MAX_BUS_WIDTH) {
+      continue;
+    }
+    vector<const hcmNode*> bits;
+    for (int i = from; i != to + step; i += step) {
+      nI = nodesMap.find(busNodeName((*bI).first, i));
+      if (nI == nodesMap.end() || !dumped.count((*nI).second)) {
+        break;
+      }
+      bits.push_back((*nI).second);
+    }
+    if ((int)bits.size() != width) {
+      continue;
+    }
+    addSignal((*bI).first, width, "[" + to_string(from) + ":" + to_string(to) + "]");
+    for (int pos = 0; pos < width; pos++) {
+      addBit(parentInsts, bits[pos], pos);
+      dumped.erase(bits[pos]);
     }
-    else if ((!debug_mode) && (node->getPort())) {
-      string code = getVCDId(codeByNodeCtx.size()+1);
-      hcmNodeCtx nodeCtx(parentInsts, node);
-      codeByNodeCtx[nodeCtx] = code;
-      vcd << "$var wire 1 " << code << " " << name << " $end" << endl;
+  }
+
+  for (nI = nodesMap.begin(); nI != nodesMap.end(); nI++) {
+    const hcmNode* node = (*nI).second;
+    if (dumped.count(node)) {
+      addSignal(node->getName(), 1, "");
+      addBit(parentInsts, node, 0);
     }
   }
   
@@ -99,73 +134,371 @@ int vcdFormatter::dfsVCDScope(list<const hcmInstance*>& parentInsts) {
     dfsVCDScope(iParents);
   }
 
-  vcd << "$upscope $end" << endl;
+  hdr << "$upscope $end\n";
+  if (wave) {
+    wave->popScope();
+  }
   return(0);
 }
 
+int vcdFormatter::addSignal(string name, int width, string range) {
+  string code = getVCDId(codes.size() + 1);
+  hdr << "$var wire " << width << " " << code << " " << name;
+  if (width > 1) {
+    hdr << " " << range;
+  }
+  hdr << " $end\n";
+  if (wave) {
+    wave->addSignal(width > 1 ? name + " " + range : name, width);
+  }
+  codes.push_back(code);
+  sigValues.push_back(string(width, 'x'));
+  sigWritten.push_back(string(width, 'x'));
+  sigDirty.push_back(0);
+  return(codes.size() - 1);
+}
+
+void vcdFormatter::addBit(list<const hcmInstance*>& parentInsts, const hcmNode* node, int pos) {
+  hcmNodeCtx nodeCtx(parentInsts, node);
+  handleByNodeCtx[nodeCtx] = values.size();
+  values.push_back(-1);
+  bitSignal.push_back(codes.size() - 1);
+  bitPos.push_back(pos);
+}
+
+int vcdDumpControl::parseWindow(string window) {
+  size_t colon = window.find(':');
+  if (colon == string::npos) {
+    return(1);
+  }
+  string start = window.substr(0, colon);
+  string stop = window.substr(colon + 1);
+  char* end;
+  if (!start.empty()) {
+    startTime = strtoul(start.c_str(), &end, 10);
+    if (*end) {
+      return(1);
+    }
+  }
+  if (!stop.empty()) {
+    stopTime = strtoul(stop.c_str(), &end, 10);
+    if (*end) {
+      return(1);
+    }
+  }
+  return(startTime > stopTime);
+}
+
+void vcdFormatter::traceCones() {
+  list<const hcmNode*> queue;
+  for (size_t o = 0; o < control.coneOutputs.size(); o++) {
+    const hcmNode* node = topCell->getNode(control.coneOutputs[o]);
+    if (!node) {
+      cerr << "-W- Cone output not found: " << control.coneOutputs[o] << endl;
+      continue;
+    }
+    if (coneNodes.insert(node).second) {
+      queue.push_back(node);
+    }
+  }
+
+  // walk from every node to the inputs of the instances driving it
+  while (!queue.empty()) {
+    const hcmNode* node = queue.front();
+    queue.pop_front();
+    map<string, hcmInstPort*>::const_iterator ipI;
+    for (ipI = node->getInstPorts().begin(); ipI != node->getInstPorts().end(); ipI++) {
+      const hcmInstPort* driver = (*ipI).second;
+      if (driver->getPort()->getDirection() == IN) {
+        continue;
+      }
+      map<string, hcmInstPort*>::const_iterator inI;
+      const map<string, hcmInstPort*>& instPorts = driver->getInst()->getInstPorts();
+      for (inI = instPorts.begin(); inI != instPorts.end(); inI++) {
+        const hcmInstPort* input = (*inI).second;
+        if (input->getPort()->getDirection() == OUT || glbNodeNames.count(input->getNode()->getName())) {
+          continue;
+        }
+        if (coneNodes.insert(input->getNode()).second) {
+          queue.push_back(input->getNode());
+        }
+      }
+    }
+  }
+}
+
+bool vcdFormatter::isSelected(list<const hcmInstance*>& parentInsts, const hcmNode* node) {
+  if (!control.selectsSignals()) {
+    return(debug_mode || node->getPort());
+  }
+  if (parentInsts.empty() && coneNodes.count(node)) {
+    return(true);
+  }
+  string name = hcmNodeCtx(parentInsts, node).getName();
+  for (size_t g = 0; g < control.signalGlobs.size(); g++) {
+    if (!fnmatch(control.signalGlobs[g].c_str(), name.c_str(), 0)) {
+      return(true);
+    }
+  }
+  for (size_t s = 0; s < control.scopes.size(); s++) {
+    const string& scope = control.scopes[s];
+    if (name.size() > scope.size() && !name.compare(0, scope.size(), scope) && name[scope.size()] == '/') {
+      return(true);
+    }
+  }
+  return(false);
+}
+
+void vcdFormatter::flushChanges() {
+  if (curTime < control.startTime || curTime > control.stopTime) {
+    // outside the window the values are kept but not written
+    for (size_t d = 0; d < dirtySignals.size(); d++) {
+      sigDirty[dirtySignals[d]] = 0;
+    }
+    dirtySignals.clear();
+    return;
+  }
+  if (!windowOpen) {
+    // entering the window all the known values are written
+    windowOpen = true;
+    dirtySignals.clear();
+    for (size_t sig = 0; sig < codes.size(); sig++) {
+      sigDirty[sig] = 1;
+      dirtySignals.push_back(sig);
+    }
+  }
+  for (size_t d = 0; d < dirtySignals.size(); d++) {
+    int sig = dirtySignals[d];
+    sigDirty[sig] = 0;
+    const string& value = sigValues[sig];
+    if (value == sigWritten[sig]) {
+      continue;
+    }
+    sigWritten[sig] = value;
+    if (wave) {
+      // the wave file has no partially known values, a bus is written once all its bits are known
+      if (value.find('x') != string::npos) {
+        continue;
+      }
+      uint64_t word = 0;
+      for (size_t b = 0; b < value.size(); b++) {
+        word = (word << 1) | (value[b] == '1');
+      }
+      wave->changeValue(sig, word);
+      continue;
+    }
+    if (value.size() == 1) {
+      buf += value;
+    } else {
+      // leading zeros are implied, unless followed by an unknown bit
+      size_t first = value.find_first_not_of('0');
+      if (first == string::npos) {
+        first = value.size() - 1;
+      } else if (first && value[first] != '1') {
+        first--;
+      }
+      buf += 'b';
+      buf.append(value, first, string::npos);
+      buf += ' ';
+    }
+    buf += codes[sig];
+    buf += '\n';
+  }
+  dirtySignals.clear();
+  if (buf.size() >= VCD_BLOCK_SIZE) {
+    out->write(buf.data(), buf.size());
+    buf.clear();
+  }
+}
+
 int vcdFormatter::genVCDHeader() {
   time_t rawtime;
   time (&rawtime);
-  vcd << "$date" << endl;
-  vcd << "     " << ctime(&rawtime) << endl;
-  vcd << "$end" << endl;
-  vcd << "$version" << endl;
-  vcd << "     Generated by HCM VCD formatter for cell: " << topCell->getName() << endl;
-  vcd << "$end" << endl;
-  vcd << "$timescale" << endl;
-  vcd << "     1s" << endl;
-  vcd << "$end" << endl;
+  hdr << "$date\n";
+  hdr << "     " << ctime(&rawtime) << "\n";
+  hdr << "$end\n";
+  hdr << "$version\n";
+  hdr << "     Generated by HCM VCD formatter for cell: " << topCell->getName() << "\n";
+  hdr << "$end\n";
+  hdr << "$timescale\n";
+  hdr << "     1s\n";
+  hdr << "$end\n";
 
   list<const hcmInstance*> noParents;
   if (dfsVCDScope(noParents)) {
     return(1);
   }
 
-  vcd << "$enddefinitions $end" << endl;
-  vcd << "#0" << endl; 
-  vcd << "$dumpvars" << endl;
+  hdr << "$enddefinitions $end\n";
+  hdr << "#0\n"; 
+  hdr << "$dumpvars\n";
   return(0);  
 }
 
-vcdFormatter::vcdFormatter(string fileName, const hcmCell* cell, set<string>& glbNodeNames_, bool debug_mode_) {
+vcdRingWriter::vcdRingWriter(string fileName, size_t ringSize) :
+  head(0), tail(0), done(false), highWater(0), stallTime(0) {
+  fp = fopen(fileName.c_str(), "w");
+  if (!fp) {
+    return;
+  }
+  ring.resize(ringSize);
+  writer = thread(&vcdRingWriter::run, this);
+}
+
+vcdRingWriter::~vcdRingWriter() {
+  close();
+}
+
+void vcdRingWriter::run() {
+  unique_lock<mutex> guard(lock);
+  while (true) {
+    notEmpty.wait(guard, [this] { return(done || head != tail); });
+    if (head == tail) {
+      break;
+    }
+    // write the contiguous part of the ring without holding the lock, the producer
+    // does not overwrite it before tail moves
+    size_t start = tail % ring.size();
+    size_t len = min(head - tail, ring.size() - start);
+    guard.unlock();
+    fwrite(&ring[start], 1, len, fp);
+    guard.lock();
+    tail += len;
+    notFull.notify_one();
+  }
+}
+
+void vcdRingWriter::write(const char* data, size_t len) {
+  unique_lock<mutex> guard(lock);
+  while (len) {
+    if (head - tail == ring.size()) {
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      notFull.wait(guard, [this] { return(head - tail < ring.size()); });
+      stallTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    size_t start = head % ring.size();
+    size_t n = min(len, min(ring.size() - (head - tail), ring.size() - start));
+    memcpy(&ring[start], data, n);
+    head += n;
+    data += n;
+    len -= n;
+    highWater = max(highWater, head - tail);
+    notEmpty.notify_one();
+  }
+}
+
+void vcdRingWriter::close() {
+  if (!fp) {
+    return;
+  }
+  {
+    lock_guard<mutex> guard(lock);
+    done = true;
+  }
+  notEmpty.notify_one();
+  writer.join();
+  fclose(fp);
+  fp = NULL;
+}
+
+vcdFormatter::vcdFormatter(string fileName, const hcmCell* cell, set<string>& glbNodeNames_, bool debug_mode_,
+                           bool binary, const vcdDumpControl* control_) {
   debug_mode = debug_mode_;
   topCell = cell;
-  vcd.open(fileName.c_str());
-  if (!vcd.good()) {
-    is_good = false;
+  out = NULL;
+  wave = NULL;
+  curTime = 0;
+  windowOpen = false;
+  if (control_) {
+    control = *control_;
+  }
+  if (binary) {
+    wave = new hcmWaveWriter(fileName);
+    is_good = wave->good();
+  } else {
+    out = new vcdRingWriter(fileName);
+    is_good = out->good();
+  }
+  if (!is_good) {
     return;
   }
 
   glbNodeNames = glbNodeNames_;
+  traceCones();
 
   if (genVCDHeader()) {
     is_good = false;
     return;
   }
+  if (!wave) {
+    buf = hdr.str();
+  }
+  hdr.str("");
   is_good = true;
 }
 
 vcdFormatter::~vcdFormatter() {
-  codeByNodeCtx.clear();
-  vcd.close();
+  handleByNodeCtx.clear();
+  close();
+  delete out;
+  delete wave;
 }
 
-int vcdFormatter::changeTime(unsigned long int newTime) {
-  vcd << "#" << newTime << endl;
-  return(0);
+void vcdFormatter::close() {
+  if (is_good) {
+    flushChanges();
+  }
+  if (wave) {
+    wave->close();
+    return;
+  }
+  if (!out || !out->good()) {
+    return;
+  }
+  out->write(buf.data(), buf.size());
+  buf.clear();
+  out->close();
 }
 
-int vcdFormatter::changeValue(const hcmNodeCtx* nodeCtx, bool value) {
-  if ((!debug_mode) && (!nodeCtx->getNode()->getPort())) {
+void vcdFormatter::printWriterStats(ostream& os) const {
+  if (wave) {
+    os << "-I- Wave writer: " << wave->getFileBytes() << " bytes in " << wave->getNumBlocks()
+       << " blocks, " << wave->getRawBytes() << " bytes before compression" << endl;
+    return;
+  }
+  if (!out) {
+    return;
+  }
+  os << "-I- VCD writer: " << out->getBytesWritten() << " bytes, ring high-water "
+     << out->getHighWater() << " of " << out->getRingSize() << " bytes, stalled "
+     << out->getStallTime() << " sec" << endl;
+}
+
+int vcdFormatter::changeTime(unsigned long int newTime) {
+  flushChanges();
+  curTime = newTime;
+  if (wave) {
+    wave->changeTime(newTime);
     return(0);
   }
-  map<const hcmNodeCtx, string, cmpNodeCtx>::const_iterator cI = codeByNodeCtx.find(*nodeCtx);
-  if (cI == codeByNodeCtx.end()) {
-    cerr << "-E- Could not find VCD context for node: " << nodeCtx->getName() << endl;
-    return(1);
+  if (newTime < control.startTime || newTime > control.stopTime) {
+    return(0);
   }
-  string code = (*cI).second;
-  vcd << (value ? "1" : "0") << code << endl;
-  
+  buf += '#';
+  buf += to_string(newTime);
+  buf += '\n';
   return(0);
 }
+
+int vcdFormatter::getHandle(const hcmNodeCtx* nodeCtx) {
+  map<const hcmNodeCtx, int, cmpNodeCtx>::const_iterator hI = handleByNodeCtx.find(*nodeCtx);
+  if (hI == handleByNodeCtx.end()) {
+    return(-1);
+  }
+  return((*hI).second);
+}
+
+int vcdFormatter::changeValue(const hcmNodeCtx* nodeCtx, bool value) {
+  // a node that is not dumped has no handle and is ignored
+  return(changeValue(getHandle(nodeCtx), value));
+}
@@ -0,0 +1,462 @@
+#include <string.h>
+#include <algorithm>
+#include <zlib.h>
+#include "hcmwave.h"
+
+using namespace std;
+
+// --------------------- static functions ---------------------
+static void putVarint(string& s, uint64_t v) {
+  while (v >= 0x80) {
+    s += (char)(v | 0x80);
+    v >>= 7;
+  }
+  s += (char)v;
+}
+
+static int getVarint(const unsigned char*& p, const unsigned char* end, uint64_t& v) {
+  v = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    unsigned char c = *p++;
+    v |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      return(0);
+    }
+  }
+  return(1);
+}
+
+static void putString(string& s, const string& str) {
+  putVarint(s, str.size());
+  s += str;
+}
+
+static int getString(const unsigned char*& p, const unsigned char* end, string& str) {
+  uint64_t len;
+  if (getVarint(p, end, len) || (uint64_t)(end - p) < len) {
+    return(1);
+  }
+  str.assign((const char*)p, len);
+  p += len;
+  return(0);
+}
+
+static void putFixed(string& s, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    s += (char)(v >> (8 * i));
+  }
+}
+
+static uint64_t getFixed(const unsigned char* p, int bytes) {
+  uint64_t v = 0;
+  for (int i = 0; i < bytes; i++) {
+    v |= (uint64_t)p[i] << (8 * i);
+  }
+  return(v);
+}
+
+static int compressString(const string& raw, string& comp) {
+  uLongf compSize = compressBound(raw.size());
+  comp.resize(compSize);
+  if (compress2((Bytef*)&comp[0], &compSize, (const Bytef*)raw.data(), raw.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+    return(1);
+  }
+  comp.resize(compSize);
+  return(0);
+}
+
+static int uncompressFile(FILE* fp, size_t rawSize, size_t compSize, vector<unsigned char>& raw) {
+  vector<unsigned char> comp(compSize);
+  uLongf size = rawSize;
+  raw.resize(rawSize);
+  if (fread(comp.data(), 1, compSize, fp) != compSize ||
+      uncompress(raw.data(), &size, comp.data(), compSize) != Z_OK || size != rawSize) {
+    return(1);
+  }
+  return(0);
+}
+// --------------------- static functions ---------------------
+
+hcmWaveWriter::hcmWaveWriter(string fileName) :
+  headerDone(false), blockBytes(0), curTime(0), blockStart(0), fileBytes(0), rawBytes(0) {
+  out = new vcdRingWriter(fileName);
+  is_good = out->good();
+}
+
+hcmWaveWriter::~hcmWaveWriter() {
+  close();
+  delete out;
+}
+
+void hcmWaveWriter::writeRaw(const string& data) {
+  out->write(data.data(), data.size());
+  fileBytes += data.size();
+}
+
+void hcmWaveWriter::pushScope(string name) {
+  sigTable += 'S';
+  putString(sigTable, name);
+}
+
+void hcmWaveWriter::popScope() {
+  sigTable += 'U';
+}
+
+int hcmWaveWriter::addSignal(string name, unsigned width) {
+  sigTable += 'V';
+  putVarint(sigTable, width);
+  putString(sigTable, name);
+  widths.push_back(width);
+  values.push_back(0);
+  blockValues.push_back(0);
+  known.push_back(0);
+  blockKnown.push_back(0);
+  streams.push_back(string());
+  lastTime.push_back(0);
+  numChanges.push_back(0);
+  return(widths.size() - 1);
+}
+
+void hcmWaveWriter::writeHeader() {
+  if (headerDone) {
+    return;
+  }
+  headerDone = true;
+  string hdr(HWV_MAGIC);
+  string comp;
+  if (compressString(sigTable, comp)) {
+    cerr << "-E- Failed to compress the wave signal table" << endl;
+    is_good = false;
+    return;
+  }
+  putFixed(hdr, sigTable.size(), 4);
+  putFixed(hdr, comp.size(), 4);
+  writeRaw(hdr);
+  writeRaw(comp);
+  sigTable.clear();
+}
+
+void hcmWaveWriter::changeTime(unsigned long newTime) {
+  if (blockBytes >= HWV_BLOCK_SIZE) {
+    flushBlock();
+    blockStart = newTime;
+  }
+  curTime = newTime;
+}
+
+void hcmWaveWriter::changeValue(int handle, uint64_t value) {
+  if (!headerDone) {
+    writeHeader();
+    blockStart = curTime;
+  }
+  string& stream = streams[handle];
+  if (stream.empty()) {
+    changed.push_back(handle);
+    lastTime[handle] = blockStart;
+  }
+  size_t before = stream.size();
+  uint64_t dt = curTime - lastTime[handle];
+  if (widths[handle] == 1) {
+    putVarint(stream, (dt << 1) | (value & 1));
+  } else {
+    putVarint(stream, dt);
+    putVarint(stream, value);
+  }
+  blockBytes += stream.size() - before;
+  lastTime[handle] = curTime;
+  numChanges[handle]++;
+  values[handle] = value;
+  known[handle] = 1;
+}
+
+void hcmWaveWriter::flushBlock() {
+  writeHeader();
+
+  // the values at the block start, then per changed signal: handle delta, count, stream
+  string raw;
+  for (size_t h = 0; h < blockValues.size(); h++) {
+    raw += blockKnown[h];
+    if (blockKnown[h]) {
+      putVarint(raw, blockValues[h]);
+    }
+  }
+  sort(changed.begin(), changed.end());
+  putVarint(raw, changed.size());
+  int prev = 0;
+  for (size_t c = 0; c < changed.size(); c++) {
+    int h = changed[c];
+    putVarint(raw, h - prev);
+    putVarint(raw, numChanges[h]);
+    putString(raw, streams[h]);
+    prev = h;
+    streams[h].clear();
+    numChanges[h] = 0;
+  }
+  changed.clear();
+  blockBytes = 0;
+  blockValues = values;
+  blockKnown = known;
+
+  string comp;
+  if (compressString(raw, comp)) {
+    cerr << "-E- Failed to compress wave block at time " << blockStart << endl;
+    is_good = false;
+    return;
+  }
+
+  hcmWaveBlockInfo info = { blockStart, curTime, fileBytes };
+  index.push_back(info);
+  string hdr;
+  putFixed(hdr, blockStart, 8);
+  putFixed(hdr, curTime, 8);
+  putFixed(hdr, raw.size(), 4);
+  putFixed(hdr, comp.size(), 4);
+  writeRaw(hdr);
+  writeRaw(comp);
+  rawBytes += raw.size();
+}
+
+void hcmWaveWriter::close() {
+  if (!out->good()) {
+    return;
+  }
+  if (!changed.empty() || index.empty()) {
+    flushBlock();
+  }
+  uint64_t indexOffset = fileBytes;
+  string footer;
+  for (size_t b = 0; b < index.size(); b++) {
+    putFixed(footer, index[b].startTime, 8);
+    putFixed(footer, index[b].endTime, 8);
+    putFixed(footer, index[b].offset, 8);
+  }
+  putFixed(footer, index.size(), 8);
+  putFixed(footer, indexOffset, 8);
+  putFixed(footer, curTime, 8);
+  footer += HWV_INDEX_MAGIC;
+  writeRaw(footer);
+  out->close();
+}
+
+hcmWaveReader::hcmWaveReader(string fileName) : endTime(0), fileBytes(0) {
+  is_good = false;
+  fp = fopen(fileName.c_str(), "rb");
+  if (!fp) {
+    cerr << "-E- Could not open wave file: " << fileName << endl;
+    return;
+  }
+  fseek(fp, 0, SEEK_END);
+  fileBytes = ftell(fp);
+  if (readHeader() || readIndex()) {
+    cerr << "-E- Corrupted wave file: " << fileName << endl;
+    return;
+  }
+  is_good = true;
+}
+
+hcmWaveReader::~hcmWaveReader() {
+  if (fp) {
+    fclose(fp);
+  }
+}
+
+int hcmWaveReader::readHeader() {
+  unsigned char fixed[16];
+  fseek(fp, 0, SEEK_SET);
+  if (fread(fixed, 1, 16, fp) != 16 || memcmp(fixed, HWV_MAGIC, 8)) {
+    return(1);
+  }
+  vector<unsigned char> table;
+  if (uncompressFile(fp, getFixed(fixed + 8, 4), getFixed(fixed + 12, 4), table)) {
+    return(1);
+  }
+
+  const unsigned char* p = table.data();
+  const unsigned char* end = p + table.size();
+  vector<string> scopes;
+  while (p < end) {
+    hcmWaveScopeRec rec;
+    rec.type = *p++;
+    rec.handle = -1;
+    rec.width = 0;
+    if (rec.type == 'S') {
+      if (getString(p, end, rec.name)) {
+        return(1);
+      }
+      scopes.push_back(rec.name);
+    } else if (rec.type == 'V') {
+      uint64_t width;
+      if (getVarint(p, end, width) || getString(p, end, rec.name)) {
+        return(1);
+      }
+      rec.width = width;
+      rec.handle = names.size();
+      string name;
+      for (size_t s = 0; s < scopes.size(); s++) {
+        name += scopes[s] + ".";
+      }
+      names.push_back(name + rec.name);
+      widths.push_back(rec.width);
+    } else if (rec.type == 'U') {
+      if (scopes.empty()) {
+        return(1);
+      }
+      scopes.pop_back();
+    } else {
+      return(1);
+    }
+    scopeRecs.push_back(rec);
+  }
+  return(0);
+}
+
+int hcmWaveReader::readIndex() {
+  unsigned char footer[32];
+  // readHeader leaves the file right after the signal table
+  uint64_t dataStart = ftell(fp);
+  if (fileBytes >= dataStart + 32) {
+    fseek(fp, fileBytes - 32, SEEK_SET);
+    if (fread(footer, 1, 32, fp) == 32 && !memcmp(footer + 24, HWV_INDEX_MAGIC, 8)) {
+      uint64_t numBlocks = getFixed(footer, 8);
+      uint64_t indexOffset = getFixed(footer + 8, 8);
+      endTime = getFixed(footer + 16, 8);
+      vector<unsigned char> idx(numBlocks * 24);
+      fseek(fp, indexOffset, SEEK_SET);
+      if (fread(idx.data(), 1, idx.size(), fp) != idx.size()) {
+        return(1);
+      }
+      for (uint64_t b = 0; b < numBlocks; b++) {
+        hcmWaveBlockInfo info;
+        info.startTime = getFixed(&idx[b * 24], 8);
+        info.endTime = getFixed(&idx[b * 24 + 8], 8);
+        info.offset = getFixed(&idx[b * 24 + 16], 8);
+        blocks.push_back(info);
+      }
+      return(0);
+    }
+  }
+
+  // no footer - walk the complete blocks
+  uint64_t offset = dataStart;
+  unsigned char hdr[24];
+  while (offset + 24 <= fileBytes) {
+    fseek(fp, offset, SEEK_SET);
+    if (fread(hdr, 1, 24, fp) != 24) {
+      break;
+    }
+    uint64_t compSize = getFixed(hdr + 20, 4);
+    if (offset + 24 + compSize > fileBytes) {
+      break;
+    }
+    hcmWaveBlockInfo info = { (unsigned long)getFixed(hdr, 8), (unsigned long)getFixed(hdr + 8, 8), offset };
+    blocks.push_back(info);
+    endTime = info.endTime;
+    offset += 24 + compSize;
+  }
+  cerr << "-W- Wave file has no index, recovered " << blocks.size() << " blocks" << endl;
+  return(0);
+}
+
+int hcmWaveReader::findBlock(unsigned long time) const {
+  int lo = 0;
+  int hi = blocks.size() - 1;
+  int res = -1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (blocks[mid].startTime <= time) {
+      res = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  if (res < 0 && !blocks.empty()) {
+    res = 0;
+  }
+  return(res);
+}
+
+int hcmWaveReader::readBlock(int block, vector<uint64_t>& startValues, vector<char>& startKnown, vector<hcmWaveChange>& changes) {
+  unsigned char hdr[24];
+  fseek(fp, blocks[block].offset, SEEK_SET);
+  if (fread(hdr, 1, 24, fp) != 24) {
+    return(1);
+  }
+  unsigned long startTime = getFixed(hdr, 8);
+  vector<unsigned char> raw;
+  if (uncompressFile(fp, getFixed(hdr + 16, 4), getFixed(hdr + 20, 4), raw)) {
+    return(1);
+  }
+
+  const unsigned char* p = raw.data();
+  const unsigned char* end = p + raw.size();
+  uint64_t v;
+  startValues.assign(names.size(), 0);
+  startKnown.assign(names.size(), 0);
+  for (size_t h = 0; h < names.size(); h++) {
+    if (p >= end) {
+      return(1);
+    }
+    startKnown[h] = *p++;
+    if (startKnown[h] && getVarint(p, end, startValues[h])) {
+      return(1);
+    }
+  }
+
+  uint64_t numChanged;
+  if (getVarint(p, end, numChanged)) {
+    return(1);
+  }
+  changes.clear();
+  int h = 0;
+  for (uint64_t c = 0; c < numChanged; c++) {
+    uint64_t dh, count, len;
+    if (getVarint(p, end, dh) || getVarint(p, end, count) || getVarint(p, end, len) ||
+        (uint64_t)(end - p) < len || dh + h >= names.size()) {
+      return(1);
+    }
+    h += dh;
+    const unsigned char* sEnd = p + len;
+    unsigned long t = startTime;
+    for (uint64_t i = 0; i < count; i++) {
+      hcmWaveChange change;
+      if (getVarint(p, sEnd, v)) {
+        return(1);
+      }
+      if (widths[h] == 1) {
+        t += v >> 1;
+        change.value = v & 1;
+      } else {
+        t += v;
+        if (getVarint(p, sEnd, change.value)) {
+          return(1);
+        }
+      }
+      change.time = t;
+      change.handle = h;
+      changes.push_back(change);
+    }
+    p = sEnd;
+  }
+  stable_sort(changes.begin(), changes.end(),
+              [](const hcmWaveChange& a, const hcmWaveChange& b) { return(a.time < b.time); });
+  return(0);
+}
+
+int hcmWaveReader::getValues(unsigned long time, vector<uint64_t>& values, vector<char>& known) {
+  int block = findBlock(time);
+  values.assign(names.size(), 0);
+  known.assign(names.size(), 0);
+  if (block < 0) {
+    return(0);
+  }
+  vector<hcmWaveChange> changes;
+  if (readBlock(block, values, known, changes)) {
+    return(1);
+  }
+  for (size_t c = 0; c < changes.size() && changes[c].time <= time; c++) {
+    values[changes[c].handle] = changes[c].value;
+    known[changes[c].handle] = 1;
+  }
+  return(0);
+}
@@ -4,6 +4,7 @@
 // #include "hcm_common.h"
 #include <map>
 #include <set>
+#include <string>
 
 using namespace std;
 
@@ -15,9 +15,15 @@ class hcmDesign : public hcmObject {
 
   // Abstraction Function:
     //  cells - a mapping between the name of a cell and the pointer to the hcmCell object.
+    //  flatCells - a mapping between a (cell name, global nodes) pair and the flat model of that cell.
   private:
     map< string, class hcmCell* > cells;
 
+    // flatCells - container of tuples of type (pair<string, set<string> >, hcmCell*) -
+    // for each tuple, the pair repersent the name of a folded cell and the global nodes it was flattened with,
+    // and the hcmCell* is the flat model generated for it (memoized by hcmFlatten).
+    map< pair< string, set<string> >, class hcmCell* > flatCells;
+
   public:
 
     /** @fn hcmDesign(string name)
@@ -59,6 +65,32 @@ class hcmDesign : public hcmObject {
      */
     hcmCell* getCell(string name);
   
+    /** @fn hcmCell *getFlatCell(string name, const set<string>& globalNodes)
+     * @brief return the memoized flat model of the cell with the corresponding name.
+     * @param name - the name of the folded cell.
+     * @param globalNodes - the global nodes the cell was flattened with.
+     * @return pointer to the flat hcmCell\n
+     *         Null if the cell was not flattened with these global nodes.
+     */
+    hcmCell* getFlatCell(string name, const set<string>& globalNodes);
+
+    /** @fn void setFlatCell(string name, const set<string>& globalNodes, hcmCell* flatCell)
+     * @brief memoize \a flatCell as the flat model of the cell with the corresponding name.\n
+     * the entry is dropped once either of the cells is deleted from the design.
+     * @param name - the name of the folded cell.
+     * @param globalNodes - the global nodes the cell was flattened with.
+     * @param flatCell - the flat model, a cell of this design.
+     * @return none
+     */
+    void setFlatCell(string name, const set<string>& globalNodes, hcmCell* flatCell);
+
+    /** @fn void clearFlatCells()
+     * @brief forget all the memoized flat models.\n
+     * should be called after editing a cell that was already flattened.
+     * @return none
+     */
+    void clearFlatCells();
+
     /** @fn void printInfo()
      * @brief print information about this object.
      * @return none
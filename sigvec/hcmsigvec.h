@@ -1,7 +1,11 @@
+#ifndef __HCMSIGVEC_H__
+#define __HCMSIGVEC_H__
 #include <fstream>
 #include <map>
 #include <set>
 #include <vector>
+#include <string>
+#include <stdint.h>
 
 using namespace std;
 
@@ -33,17 +37,42 @@ class hcmSigVec {
     // mapping from signal name to idx
     map<string, int> signalVecIdx; 
 
+    // the vectors loaded by loadAllVectors as packed bit matrices, 64 bits per word.
+    // vector-major - the bits of vector v are words [v * wordsPerVector, (v + 1) * wordsPerVector)
+    // signal-major - the bits of signal i are words [i * wordsPerSignal, (i + 1) * wordsPerSignal),
+    //                transposed from the vector-major matrix on the first getSignalWords
+    int numVectors;
+    int wordsPerVector;
+    int wordsPerSignal;
+    vector<uint64_t> vectorMajor;
+    vector<uint64_t> signalMajor;
+
     /** @fn int parseSignalsFile()
      * @brief create a mapping between signal to it's index
      * @return 0 on success
      */
     int parseSignalsFile();
 
+    /** @fn void transposeVectors()
+     * @brief build the signal-major matrix from the vector-major one.
+     */
+    void transposeVectors();
+
+    /** @fn int decodeLine(const char* begin, const char* end, unsigned int lineNum, uint64_t* words)
+     * @brief decode a line of the vector file into packed bits, bit i is the value of signal idx i.
+     * @param begin - the first character of the line
+     * @param end - one past the last character of the line
+     * @param lineNum - the line number for messages
+     * @param words - the words to set, wordsPerVector of them
+     * @return 0 on success, 1 if the line is empty or not a valid hexadecimal number
+     */
+    int decodeLine(const char* begin, const char* end, unsigned int lineNum, uint64_t* words);
+
   public:
     /** @fn hcmSigVec(string sigsFileName, string vecsFileName, bool verbose = false)
      * @brief hcmSigVec constractor.
      * @param sigsFileName - name of the signal file 
-     * @param vecsFileName - name of the vector file 
+     * @param vecsFileName - name of the vector file, may be empty if only the signals are needed
      * @param verbose - boolean variable to determine whether to print comments
      */
     hcmSigVec(string sigsFileName_, string vecsFileName_, bool verbose_ = false);
@@ -77,8 +106,57 @@ class hcmSigVec {
      * @return number of signals.
      */
     int getSignals(set<string>& signals);
-};
 
+    /** @fn int getNumSignals() const
+     * @brief gets the number of single bit signals.
+     */
+    int getNumSignals() const { return(sigValsByIdx.size()); };
 
+    /** @fn int getSignalIdx(string sigName) const
+     * @brief gets the index of the signal, its bit position in every vector.
+     * @return the index, -1 if the signal is unknown
+     */
+    int getSignalIdx(string sigName) const;
 
+    /** @fn int getSigValue(int idx, bool& val) const
+     * @brief get the value of the signal with the given index in the last vector read by readVector.
+     * @return 1 if the index is out of range\n
+     * 0 if the operation succeeded
+     */
+    int getSigValue(int idx, bool& val) const;
+
+    /** @fn int loadAllVectors()
+     * @brief map the vector file to memory and decode all its vectors into the packed bit matrices.
+     * reading stops at the first line readVector would fail on, like the readVector loop does.
+     * @return 0 on success, 1 if the file could not be mapped
+     */
+    int loadAllVectors();
+
+    /** @fn int getNumVectors() const
+     * @brief gets the number of vectors decoded by loadAllVectors.
+     */
+    int getNumVectors() const { return(numVectors); };
+
+    /** @fn bool getBit(int vec, int idx) const
+     * @brief gets the value of the signal with the given index in the given vector.
+     */
+    bool getBit(int vec, int idx) const {
+      return((vectorMajor[(size_t)vec * wordsPerVector + idx / 64] >> (idx % 64)) & 1);
+    };
+
+    /** @fn const uint64_t* getVectorWords(int vec) const
+     * @brief gets the packed bits of a vector, bit i is the value of signal idx i.
+     */
+    const uint64_t* getVectorWords(int vec) const { return(&vectorMajor[(size_t)vec * wordsPerVector]); };
+
+    /** @fn const uint64_t* getSignalWords(int idx)
+     * @brief gets the packed values of a signal in all vectors, bit v is its value in vector v.
+     * every word holds 64 consecutive vectors. the first call transposes all the loaded vectors.
+     */
+    const uint64_t* getSignalWords(int idx);
+
+    int getWordsPerVector() const { return(wordsPerVector); };
+    int getWordsPerSignal() const { return(wordsPerSignal); };
+};
 
+#endif //__HCMSIGVEC_H__
@@ -0,0 +1,140 @@
+#ifndef __HCMSTIM_H__
+#define __HCMSTIM_H__
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "hcmsigvec.h"
+
+using namespace std;
+
+// the largest number of signals exhaustive stimulus is allowed on
+#define HCM_STIM_MAX_EXHAUSTIVE 32
+
+/**
+ * hcmStimulus class is the base of all the stimulus sources. a source produces the vectors one
+ * after the other as packed bits, bit i of the words is the value of the signal with idx i
+ * (the signal order of the hcmSigVec signal file).
+ * hcmStimulus is a mutable object.
+ */
+class hcmStimulus {
+  protected:
+    int numSignals;
+    int wordsPerVector;
+    // number of vectors to produce and produced so far
+    uint64_t numVectors;
+    uint64_t vecIdx;
+
+    /** @fn void maskTail(uint64_t* words) const
+     * @brief clear the bits above the last signal in the last word of a vector.
+     */
+    void maskTail(uint64_t* words) const;
+
+  public:
+    hcmStimulus(int numSignals_, uint64_t numVectors_);
+    virtual ~hcmStimulus() {};
+
+    int getNumSignals() const { return(numSignals); };
+    int getWordsPerVector() const { return(wordsPerVector); };
+    uint64_t getNumVectors() const { return(numVectors); };
+
+    /** @fn int nextVector(uint64_t* words)
+     * @brief produce the next vector.
+     * @param words - the words to set, getWordsPerVector() of them
+     * @return 0 on success, -1 if all the vectors were produced
+     */
+    int nextVector(uint64_t* words);
+
+    /** @fn virtual hcmSigVec* getVectorFile()
+     * @brief gets the loaded vector file the vectors come from, NULL if they are generated.
+     */
+    virtual hcmSigVec* getVectorFile() { return(NULL); };
+
+    /** @fn virtual void generate(uint64_t* words) = 0
+     * @brief set the words to the vector of index vecIdx.
+     */
+    virtual void generate(uint64_t* words) = 0;
+};
+
+/**
+ * hcmStimVectors - the vectors of a vector file loaded by hcmSigVec::loadAllVectors.
+ */
+class hcmStimVectors : public hcmStimulus {
+  private:
+    hcmSigVec& sigVec;
+  public:
+    hcmStimVectors(hcmSigVec& sigVec_);
+    virtual hcmSigVec* getVectorFile() { return(&sigVec); };
+    virtual void generate(uint64_t* words);
+};
+
+/**
+ * hcmStimLFSR - pseudo random vectors of a 64 bit maximal length Galois LFSR.
+ * the register is shifted 64 times for every word so consecutive words do not overlap.
+ */
+class hcmStimLFSR : public hcmStimulus {
+  private:
+    uint64_t state;
+  public:
+    hcmStimLFSR(int numSignals_, uint64_t numVectors_, uint64_t seed);
+    virtual void generate(uint64_t* words);
+};
+
+/**
+ * hcmStimXoshiro - pseudo random vectors of a xoshiro256** generator seeded by splitmix64.
+ */
+class hcmStimXoshiro : public hcmStimulus {
+  protected:
+    uint64_t s[4];
+    uint64_t next();
+  public:
+    hcmStimXoshiro(int numSignals_, uint64_t numVectors_, uint64_t seed);
+    virtual void generate(uint64_t* words);
+};
+
+/**
+ * hcmStimExhaustive - all the 2^numSignals input combinations in counting order.
+ */
+class hcmStimExhaustive : public hcmStimulus {
+  public:
+    hcmStimExhaustive(int numSignals_);
+    virtual void generate(uint64_t* words);
+};
+
+/**
+ * hcmStimWeighted - random vectors where every signal is 1 with its own probability.
+ * signals without a weight are 1 half of the time.
+ */
+class hcmStimWeighted : public hcmStimXoshiro {
+  private:
+    // per signal - how its value is drawn, a raw random bit, a 64 bit random value
+    // compared to the threshold, or always 1.
+    typedef enum { STIM_RAW, STIM_THRESHOLD, STIM_ONE } stimKind;
+    vector<stimKind> kinds;
+    vector<uint64_t> thresholds;
+  public:
+    hcmStimWeighted(int numSignals_, uint64_t numVectors_, uint64_t seed);
+
+    /** @fn int setWeight(int idx, double prob)
+     * @brief set the probability of the signal with the given idx to be 1.
+     * @return 0 on success, 1 if the idx or probability are out of range
+     */
+    int setWeight(int idx, double prob);
+
+    virtual void generate(uint64_t* words);
+};
+
+/** @fn hcmStimulus* hcmCreateStimulus(string spec, hcmSigVec& sigVec, const vector<string>& weights)
+ * @brief create the stimulus source described by \a spec for the signals of \a sigVec.
+ * @param spec - one of:\n
+ * "" - the vectors of the vector file of sigVec\n
+ * lfsr:N[:seed] - N random vectors of a LFSR\n
+ * xoshiro:N[:seed] - N random vectors of xoshiro256**\n
+ * exhaustive - all the input combinations\n
+ * weighted:N[:seed] - N random vectors, weighted per signal
+ * @param sigVec - the signals (and vectors) parser
+ * @param weights - weights for the weighted source, given as signal=probability
+ * @return pointer to the new source owned by the caller, NULL on error
+ */
+hcmStimulus* hcmCreateStimulus(string spec, hcmSigVec& sigVec, const vector<string>& weights);
+
+#endif //__HCMSTIM_H__
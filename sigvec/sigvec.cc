@@ -2,6 +2,10 @@
 #include <iostream>
 #include <sstream>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -34,20 +38,48 @@ static string trim(const string& str, const string& whitespace = " \n\r\t\f\v\0"
   
   return str.substr(strBegin, strRange);
 }
+
+/** @fn static int hexDigit(char c)
+ * @brief gets the value of a hexadecimal digit.
+ * @return the value of the digit, -1 if \a c is not a hexadecimal digit
+ */
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') {
+    return(c - '0');
+  }
+  if (c >= 'a' && c <= 'f') {
+    return(c - 'a' + 10);
+  }
+  if (c >= 'A' && c <= 'F') {
+    return(c - 'A' + 10);
+  }
+  return(-1);
+}
+
+/** @fn static bool isSpace(char c)
+ * @brief true if the character is trimmed from vector lines.
+ */
+static bool isSpace(char c) {
+  return(c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v' || c == '\0');
+}
 // --------------------- static functions ---------------------
 
 hcmSigVec::hcmSigVec(string sigsFileName_, string vecsFileName_, bool verbose_)
-  : verbose(verbose_ = false), isGood(true), vecLineNum(0), sigsFileName(sigsFileName_), vecsFileName(vecsFileName_) {
+  : verbose(verbose_ = false), isGood(true), vecLineNum(0), sigsFileName(sigsFileName_), vecsFileName(vecsFileName_),
+    numVectors(0), wordsPerVector(0), wordsPerSignal(0) {
   
   sigs.open(sigsFileName.c_str());
-  vecs.open(vecsFileName.c_str());
+  // the vector file is optional when the vectors come from a stimulus generator
+  if (!vecsFileName.empty()) {
+    vecs.open(vecsFileName.c_str());
+  }
   
   if (!sigs.good()) {
     cerr << "-E- Failed opening Signal file: " << sigsFileName << endl;
 	 isGood = false;
   }
 
-  if (!vecs.good()) {
+  if (!vecsFileName.empty() && !vecs.good()) {
     cerr << "-E- Failed opening Vector file: " << vecsFileName << endl;
 	 isGood = false;
   }
@@ -80,6 +112,23 @@ int hcmSigVec::getSigValue(string sigName, bool& val) {
   return 0;
 }
 
+int hcmSigVec::getSignalIdx(string sigName) const {
+  map<string, int>::const_iterator it = signalVecIdx.find(sigName);
+  if (it == signalVecIdx.end()) {
+    return(-1);
+  }
+  return((*it).second);
+}
+
+int hcmSigVec::getSigValue(int idx, bool& val) const {
+  if (idx < 0 || (size_t)idx >= sigValsByIdx.size()) {
+    cerr << "-E- Signal idx: " << idx << " out of range" << endl;
+    return 1;
+  }
+  val = sigValsByIdx[idx];
+  return 0;
+}
+
 int hcmSigVec::getSignals(set<string>& signals) {
   for (map<string, int>::const_iterator it = signalVecIdx.begin(); it != signalVecIdx.end(); it++) {
 	  signals.insert((*it).first);
@@ -94,47 +143,135 @@ int hcmSigVec::readVector() {
 
   string line;
   getline(vecs, line);
-  string input_vector = trim(line);
   vecLineNum++;
 
-  // the line is a long hexadecimal number as string.
-  // we need to extract one bit at a time.
+  // the line is a long hexadecimal number as string, the last digit holds signals 0 to 3.
+  vector<uint64_t> words((sigValsByIdx.size() + 63) / 64);
+  if (decodeLine(line.data(), line.data() + line.size(), vecLineNum, words.data())) {
+    return(1);
+  }
+  for (unsigned int i = 0; i < sigValsByIdx.size(); i++) {
+    sigValsByIdx[i] = (words[i / 64] >> (i % 64)) & 1;
+    if (verbose) {
+      cout << "-D- Signal idx: " << i << " = " << sigValsByIdx[i] << endl;
+    }
+  }
+  return(0);
+}
 
-  // first lets check we have enough length.
-  size_t strLen = input_vector.length();
+int hcmSigVec::decodeLine(const char* begin, const char* end, unsigned int lineNum, uint64_t* words) {
+  while (begin < end && isSpace(*begin)) {
+    begin++;
+  }
+  while (end > begin && isSpace(end[-1])) {
+    end--;
+  }
+
+  size_t strLen = end - begin;
   if (!strLen) {
-    cerr << "-E- Empty line in vector files (line: " << vecLineNum << ")" << endl;
+    cerr << "-E- Empty line in vector files (line: " << lineNum << ")" << endl;
     return(1);
   }
-
-  if (strLen < ((sigValsByIdx.size()+3)/4)) {
-    cerr << "-E- Not enough hexadecimal digits (" << strLen
-			<< " < " << ((sigValsByIdx.size()+3)/4) << ") in line:"
-			<< vecLineNum << " = " << input_vector << endl;
+  size_t numDigits = (sigValsByIdx.size() + 3) / 4;
+  if (strLen < numDigits) {
+    cerr << "-E- Not enough hexadecimal digits (" << strLen << " < " << numDigits << ") in line:"
+         << lineNum << " = " << string(begin, end) << endl;
     return(1);
   }
 
-  // convert the line string to bits assigning them by index to each signal
-  char c = input_vector[--strLen];
+  // take the digits from the end of the line, 16 digits per word
+  size_t numWords = (sigValsByIdx.size() + 63) / 64;
+  for (size_t w = 0; w < numWords; w++) {
+    words[w] = 0;
+  }
+  for (size_t d = 0; d < numDigits; d++) {
+    int digit = hexDigit(end[-1 - (long)d]);
+    if (digit < 0) {
+      cerr << "-E- Bad hexadecimal digit '" << end[-1 - (long)d] << "' in line:" << lineNum << endl;
+      return(1);
+    }
+    words[d / 16] |= (uint64_t)digit << (4 * (d % 16));
+  }
+  // clear the bits above the last signal
+  if (sigValsByIdx.size() % 64) {
+    words[numWords - 1] &= ((uint64_t)1 << (sigValsByIdx.size() % 64)) - 1;
+  }
+  return(0);
+}
 
-  string str(1, c);
-  unsigned digit = strtoul(str.c_str(), (char **) NULL, 16);
+int hcmSigVec::loadAllVectors() {
+  int fd = open(vecsFileName.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st)) {
+    cerr << "-E- Failed opening Vector file: " << vecsFileName << endl;
+    if (fd >= 0) {
+      close(fd);
+    }
+    return(1);
+  }
+  numVectors = 0;
+  wordsPerVector = (sigValsByIdx.size() + 63) / 64;
+  vectorMajor.clear();
+  if (st.st_size == 0) {
+    close(fd);
+    wordsPerSignal = 0;
+    signalMajor.clear();
+    return(0);
+  }
+  const char* data = (const char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    cerr << "-E- Failed to map Vector file: " << vecsFileName << endl;
+    return(1);
+  }
 
-  for (unsigned int i = 0; i < sigValsByIdx.size(); i++) {
-    sigValsByIdx[i] = digit & 1;
-    if (verbose) {
-      cout << "-D- Signal idx: " << i << " = " << sigValsByIdx[i] << " dig:" << digit << endl;
+  // decode line by line into the vector-major matrix
+  const char* end = data + st.st_size;
+  unsigned int lineNum = 0;
+  for (const char* line = data; line < end; ) {
+    const char* eol = line;
+    while (eol < end && *eol != '\n') {
+      eol++;
     }
-    digit = digit >> 1;
-    if ((i+1) % 4 == 0) {
-      c = input_vector[--strLen];
-      digit = strtoul(&c, (char **) NULL, 16);
-      digit &= 0xff;
+    lineNum++;
+    vectorMajor.resize(vectorMajor.size() + wordsPerVector);
+    if (decodeLine(line, eol, lineNum, &vectorMajor[vectorMajor.size() - wordsPerVector])) {
+      vectorMajor.resize(vectorMajor.size() - wordsPerVector);
+      break;
     }
+    numVectors++;
+    line = eol + 1;
+  }
+  munmap((void*)data, st.st_size);
+
+  // the signal-major matrix is built only when asked for
+  wordsPerSignal = (numVectors + 63) / 64;
+  signalMajor.clear();
+  if (verbose) {
+    cout << "-D- Loaded " << numVectors << " vectors of " << sigValsByIdx.size() << " signals" << endl;
   }
   return(0);
 }
 
+void hcmSigVec::transposeVectors() {
+  signalMajor.assign((size_t)wordsPerSignal * sigValsByIdx.size(), 0);
+  for (int v = 0; v < numVectors; v++) {
+    const uint64_t* vec = getVectorWords(v);
+    for (size_t i = 0; i < sigValsByIdx.size(); i++) {
+      if ((vec[i / 64] >> (i % 64)) & 1) {
+        signalMajor[i * wordsPerSignal + v / 64] |= (uint64_t)1 << (v % 64);
+      }
+    }
+  }
+}
+
+const uint64_t* hcmSigVec::getSignalWords(int idx) {
+  if (signalMajor.empty()) {
+    transposeVectors();
+  }
+  return(&signalMajor[(size_t)idx * wordsPerSignal]);
+}
+
 int hcmSigVec::parseSignalsFile() {
   string line;
   string prefix, fromStr, toStr;
@@ -0,0 +1,226 @@
+#include "hcmstim.h"
+#include <iostream>
+#include <stdlib.h>
+
+using namespace std;
+
+// taps of the maximal length polynomial x^64 + x^63 + x^61 + x^60 + 1
+#define HCM_STIM_LFSR_TAPS 0xD800000000000000ULL
+
+// --------------------- static functions ---------------------
+/** @fn static uint64_t splitMix64(uint64_t& x)
+ * @brief the splitmix64 generator, used to expand a seed into generator state.
+ */
+static uint64_t splitMix64(uint64_t& x) {
+  uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return(z ^ (z >> 31));
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+  return((x << k) | (x >> (64 - k)));
+}
+
+/** @fn static int parseCount(const string& str, uint64_t& val)
+ * @brief parse a positive decimal number.
+ * @return 0 on success, 1 otherwise
+ */
+static int parseCount(const string& str, uint64_t& val) {
+  if (str.empty()) {
+    return(1);
+  }
+  char* end;
+  val = strtoull(str.c_str(), &end, 10);
+  return(*end != '\0' || str[0] == '-');
+}
+// --------------------- static functions ---------------------
+
+hcmStimulus::hcmStimulus(int numSignals_, uint64_t numVectors_)
+  : numSignals(numSignals_), wordsPerVector((numSignals_ + 63) / 64), numVectors(numVectors_), vecIdx(0) {
+}
+
+void hcmStimulus::maskTail(uint64_t* words) const {
+  if (numSignals % 64) {
+    words[wordsPerVector - 1] &= (1ULL << (numSignals % 64)) - 1;
+  }
+}
+
+int hcmStimulus::nextVector(uint64_t* words) {
+  if (vecIdx >= numVectors) {
+    return(-1);
+  }
+  generate(words);
+  vecIdx++;
+  return(0);
+}
+
+hcmStimVectors::hcmStimVectors(hcmSigVec& sigVec_)
+  : hcmStimulus(sigVec_.getNumSignals(), sigVec_.getNumVectors()), sigVec(sigVec_) {
+}
+
+void hcmStimVectors::generate(uint64_t* words) {
+  const uint64_t* vec = sigVec.getVectorWords(vecIdx);
+  for (int w = 0; w < wordsPerVector; w++) {
+    words[w] = vec[w];
+  }
+}
+
+hcmStimLFSR::hcmStimLFSR(int numSignals_, uint64_t numVectors_, uint64_t seed)
+  : hcmStimulus(numSignals_, numVectors_), state(seed) {
+  // the all zero state is the only one the register never leaves
+  if (state == 0) {
+    state = 1;
+  }
+}
+
+void hcmStimLFSR::generate(uint64_t* words) {
+  for (int w = 0; w < wordsPerVector; w++) {
+    for (int b = 0; b < 64; b++) {
+      state = (state >> 1) ^ (-(state & 1) & HCM_STIM_LFSR_TAPS);
+    }
+    words[w] = state;
+  }
+  maskTail(words);
+}
+
+hcmStimXoshiro::hcmStimXoshiro(int numSignals_, uint64_t numVectors_, uint64_t seed)
+  : hcmStimulus(numSignals_, numVectors_) {
+  for (int i = 0; i < 4; i++) {
+    s[i] = splitMix64(seed);
+  }
+}
+
+uint64_t hcmStimXoshiro::next() {
+  uint64_t res = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return(res);
+}
+
+void hcmStimXoshiro::generate(uint64_t* words) {
+  for (int w = 0; w < wordsPerVector; w++) {
+    words[w] = next();
+  }
+  maskTail(words);
+}
+
+hcmStimExhaustive::hcmStimExhaustive(int numSignals_)
+  : hcmStimulus(numSignals_, 1ULL << numSignals_) {
+}
+
+void hcmStimExhaustive::generate(uint64_t* words) {
+  // at most HCM_STIM_MAX_EXHAUSTIVE signals so the counter fits the first word
+  if (wordsPerVector) {
+    words[0] = vecIdx;
+  }
+}
+
+hcmStimWeighted::hcmStimWeighted(int numSignals_, uint64_t numVectors_, uint64_t seed)
+  : hcmStimXoshiro(numSignals_, numVectors_, seed), kinds(numSignals_, STIM_RAW), thresholds(numSignals_, 0) {
+}
+
+int hcmStimWeighted::setWeight(int idx, double prob) {
+  if (idx < 0 || idx >= numSignals || !(prob >= 0.0 && prob <= 1.0)) {
+    return(1);
+  }
+  if (prob == 1.0) {
+    kinds[idx] = STIM_ONE;
+  }
+  else {
+    kinds[idx] = STIM_THRESHOLD;
+    thresholds[idx] = (uint64_t)(prob * 18446744073709551616.0);
+  }
+  return(0);
+}
+
+void hcmStimWeighted::generate(uint64_t* words) {
+  for (int w = 0; w < wordsPerVector; w++) {
+    uint64_t word = next();
+    int last = (w == wordsPerVector - 1 && numSignals % 64) ? numSignals % 64 : 64;
+    for (int b = 0; b < last; b++) {
+      int idx = w * 64 + b;
+      if (kinds[idx] == STIM_RAW) {
+        continue;
+      }
+      bool val = (kinds[idx] == STIM_ONE) || (next() < thresholds[idx]);
+      word = val ? (word | (1ULL << b)) : (word & ~(1ULL << b));
+    }
+    words[w] = word;
+  }
+  maskTail(words);
+}
+
+hcmStimulus* hcmCreateStimulus(string spec, hcmSigVec& sigVec, const vector<string>& weights) {
+  int numSignals = sigVec.getNumSignals();
+  if (spec.empty()) {
+    if (sigVec.loadAllVectors()) {
+      return(NULL);
+    }
+    return(new hcmStimVectors(sigVec));
+  }
+
+  // split the spec to kind:N:seed
+  vector<string> fields;
+  size_t pos = 0;
+  for (size_t colon; (colon = spec.find(':', pos)) != string::npos; pos = colon + 1) {
+    fields.push_back(spec.substr(pos, colon - pos));
+  }
+  fields.push_back(spec.substr(pos));
+
+  string kind = fields[0];
+  if (kind != "weighted" && !weights.empty()) {
+    cerr << "-W- Signal weights are used only by weighted stimulus, ignored" << endl;
+  }
+
+  if (kind == "exhaustive") {
+    if (fields.size() != 1) {
+      cerr << "-E- Exhaustive stimulus takes no arguments: " << spec << endl;
+      return(NULL);
+    }
+    if (numSignals > HCM_STIM_MAX_EXHAUSTIVE) {
+      cerr << "-E- Exhaustive stimulus supports up to " << HCM_STIM_MAX_EXHAUSTIVE
+           << " signals, got: " << numSignals << endl;
+      return(NULL);
+    }
+    return(new hcmStimExhaustive(numSignals));
+  }
+
+  uint64_t numVectors = 0;
+  uint64_t seed = 1;
+  if (fields.size() < 2 || fields.size() > 3 || parseCount(fields[1], numVectors) ||
+      (fields.size() == 3 && parseCount(fields[2], seed))) {
+    cerr << "-E- Bad stimulus: " << spec << " expected " << kind << ":N[:seed]" << endl;
+    return(NULL);
+  }
+
+  if (kind == "lfsr") {
+    return(new hcmStimLFSR(numSignals, numVectors, seed));
+  }
+  if (kind == "xoshiro") {
+    return(new hcmStimXoshiro(numSignals, numVectors, seed));
+  }
+  if (kind == "weighted") {
+    hcmStimWeighted* stim = new hcmStimWeighted(numSignals, numVectors, seed);
+    for (size_t i = 0; i < weights.size(); i++) {
+      size_t eq = weights[i].rfind('=');
+      int idx = (eq == string::npos) ? -1 : sigVec.getSignalIdx(weights[i].substr(0, eq));
+      char* end = NULL;
+      double prob = (eq == string::npos) ? -1.0 : strtod(weights[i].c_str() + eq + 1, &end);
+      if (idx < 0 || end == weights[i].c_str() + eq + 1 || *end != '\0' || stim->setWeight(idx, prob)) {
+        cerr << "-E- Bad signal weight: " << weights[i] << " expected signal=probability" << endl;
+        delete stim;
+        return(NULL);
+      }
+    }
+    return(stim);
+  }
+
+  cerr << "-E- Unknown stimulus: " << kind << " expected lfsr, xoshiro, exhaustive or weighted" << endl;
+  return(NULL);
+}
@@ -25,6 +25,16 @@ hcmCell *hcmDesign::createCell(string name){
 }
 
 void hcmDesign::deleteCell(string name){
+	// forget the flat models of the cell and the ones the cell is a flat model of
+	for(auto it = flatCells.begin(); it != flatCells.end(); ) {
+		if (it->first.first == name || it->second->getName() == name) {
+			it = flatCells.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
 	if(cells.count(name) == 0 ) {
 		return ;
 	}
@@ -45,7 +55,27 @@ hcmCell *hcmDesign::getCell(string name){
 	return cells[name];
 }
 
+hcmCell *hcmDesign::getFlatCell(string name, const set<string>& globalNodes){
+	auto it = flatCells.find(make_pair(name, globalNodes));
+	if(it == flatCells.end()) {
+		return NULL;
+	}
+	return it->second;
+}
+
+void hcmDesign::setFlatCell(string name, const set<string>& globalNodes, hcmCell* flatCell){
+	if(flatCell == NULL || cells.count(name) == 0) {
+		return;
+	}
+	flatCells[make_pair(name, globalNodes)] = flatCell;
+}
+
+void hcmDesign::clearFlatCells(){
+	flatCells.clear();
+}
+
 hcmDesign::~hcmDesign(){
+	flatCells.clear();
 	set<string> names;
 	for(auto it = cells.begin(); it != cells.end(); ++it) {
 		names.insert(it->first);
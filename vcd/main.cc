@@ -23,7 +23,7 @@ getRandomNodeCtx(set< vcdNodeCtx, cmpNodeCtx > &vcdNodes)
 
 int
 prepVcdNodes(hcmCell *cell,
-				 list<string> parentInstNames,
+				 int scope,
 				 set< string> &glbNodeNames,
 				 set< vcdNodeCtx, cmpNodeCtx > &vcdNodes)
 {
@@ -34,22 +34,21 @@ prepVcdNodes(hcmCell *cell,
     const hcmNode *node = (*nI).second;
     string name = node->getName();
 	 // we skip nodes connected from above if we are not on top 
-    if (node->getPort() && !parentInstNames.empty()) 
+    if (node->getPort() && scope != 0) 
       continue;
 	 // we skip global nodes
     if (glbNodeNames.find(name) != glbNodeNames.end()) 
       continue;
-	 vcdNodeCtx nodeCtx(parentInstNames, name);
+	 vcdNodeCtx nodeCtx(scope, name);
 	 vcdNodes.insert(nodeCtx);
   }
   
   // recurse on all instances
   map< string, hcmInstance* >::const_iterator iI;
   for (iI = cell->getInstances().begin(); iI != cell->getInstances().end(); iI++) { 
-    list<string> iParents = parentInstNames;
-    iParents.push_back((*iI).first);
+	 int iScope = vcdScopeTree::shared().getChild(scope, (*iI).first);
 	 hcmCell *master = (*iI).second->masterCell();
-	 prepVcdNodes(master, iParents, glbNodeNames, vcdNodes);
+	 prepVcdNodes(master, iScope, glbNodeNames, vcdNodes);
   }
 
   return(0);
@@ -121,9 +120,8 @@ int main(int argc, char **argv) {
   }
   
   // prepare the set of node contexts to declare what teh VCD will contain
-  list<string> emptyParents; // needed for starting the recursion with 0 parents
   set< vcdNodeCtx, cmpNodeCtx > vcdNodes; // collects all nodes contexts
-  prepVcdNodes(topCell, emptyParents, globalNodes, vcdNodes); // recurse getting all nodes
+  prepVcdNodes(topCell, 0, globalNodes, vcdNodes); // recurse from the top scope getting all nodes
   vcdFormatter vcd(cellName + ".vcd", cellName, vcdNodes); // initialize the VCD
   if (!vcd.good()) {
     printf("-E- Could not create vcdFormatter for cell: %s\n", 
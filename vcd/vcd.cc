@@ -11,29 +11,99 @@
 
 using namespace std;
 
+///////////////////////////////////////////////////////////////////////////
+int 
+vcdSymbolTable::intern(const string &name)
+{
+  unordered_map<string, int>::const_iterator sI = symbolByName.find(name);
+  if (sI != symbolByName.end()) 
+    return((*sI).second);
+  symbolByName[name] = names.size();
+  names.push_back(name);
+  return(names.size() - 1);
+}
+
+vcdScopeTree::vcdScopeTree()
+{
+  parent.push_back(-1);
+  nameSymbol.push_back(symbols.intern("DUT"));
+}
+
+vcdScopeTree &
+vcdScopeTree::shared()
+{
+  static vcdScopeTree tree;
+  return(tree);
+}
+
+int 
+vcdScopeTree::getChild(int scope, const string &instName)
+{
+  pair<int,int> key(scope, symbols.intern(instName));
+  map< pair<int,int>, int >::const_iterator cI = childByName.find(key);
+  if (cI != childByName.end()) 
+    return((*cI).second);
+  childByName[key] = parent.size();
+  parent.push_back(scope);
+  nameSymbol.push_back(key.second);
+  return(parent.size() - 1);
+}
+
+int 
+vcdScopeTree::getScope(const list<string> &parentInstNames)
+{
+  int scope = 0;
+  list<string>::const_iterator pI;
+  for (pI = parentInstNames.begin(); pI != parentInstNames.end(); pI++) 
+    scope = getChild(scope, *pI);
+  return(scope);
+}
+
+void 
+vcdScopeTree::getPath(int scope, vector<int> &path) const
+{
+  path.clear();
+  for (; scope > 0; scope = parent[scope]) 
+    path.push_back(scope);
+  reverse(path.begin(), path.end());
+}
+
 ///////////////////////////////////////////////////////////////////////////
 vcdNodeCtx::vcdNodeCtx(list<std::string> &p, std::string n)
 {
-  nodeName = n;
-  parentInstNames = p;
+  vcdScopeTree &tree = vcdScopeTree::shared();
+  scopeId = tree.getScope(p);
+  nameSymbol = tree.getSymbols().intern(n);
+}
+
+vcdNodeCtx::vcdNodeCtx(int scope, std::string n)
+{
+  scopeId = scope;
+  nameSymbol = vcdScopeTree::shared().getSymbols().intern(n);
+}
+
+list<string> 
+vcdNodeCtx::getParents() const
+{
+  vcdScopeTree &tree = vcdScopeTree::shared();
+  vector<int> path;
+  tree.getPath(scopeId, path);
+  list<string> res;
+  for (size_t i = 0; i < path.size(); i++) 
+    res.push_back(tree.getScopeName(path[i]));
+  return(res);
 }
 
 string
 vcdNodeCtx::getName() const
 {
+  vcdScopeTree &tree = vcdScopeTree::shared();
+  vector<int> path;
+  tree.getPath(scopeId, path);
   string res;
-  bool first = true;
-  list<string>::const_iterator pI;
-  for (pI = parentInstNames.begin(); pI != parentInstNames.end(); pI++) {
-    if (!first) 
-      res += string("/");
-    else
-      first = false;
-    res += (*pI);
-  }
-  if (!first) 
-    res += string("/");
-  res += nodeName;
+  for (size_t i = 0; i < path.size(); i++) 
+    res += tree.getScopeName(path[i]) + string("/");
+  res += getNode();
   return res;
 }
 
@@ -69,80 +139,46 @@ vcdFormatter::getNodeCtxCode(const vcdNodeCtx *nodeCtx)
   return((*cI).second);
 }
 
-#ifdef DEBUG
-static string join(list<string> l) {
-  string r;
-  list<string>::const_iterator I;
-  for (I = l.begin(); I != l.end() ; I++) {
-	 if (r.size()) {
-		r += "/";
-	 }
-	 r += *I;
-  }
-  return r;
-}
-#endif
-
 // should be called with empty parents for top
 int 
 vcdFormatter::genVCDScope(set< vcdNodeCtx, cmpNodeCtx > &vcdNodes)
 {
-  string prefix("");
+  vcdScopeTree &tree = vcdScopeTree::shared();
   vcd << "$scope module DUT $end" << endl;
-  //  prefix = prefix + " ";
-  list<string>::const_iterator pI, qI;
 
-  // we start with empty parents list
-  list<string> prevParentInstNames;
+  // we start with the top scope, its path is empty
+  int prevScope = 0;
+  vector<int> prevPath, path;
 
-  // since the set of node contexts is sorted already we can simply use it
+  // since the set of node contexts is sorted by scope we can simply use it
   set< vcdNodeCtx, cmpNodeCtx >::const_iterator ncI;
   for (ncI = vcdNodes.begin(); ncI != vcdNodes.end(); ncI++) {
 	 const vcdNodeCtx *nodeCtx = &(*ncI);
     string code = getVCDId(codeByNodeCtx.size()+1);
 	 codeByNodeCtx[nodeCtx] = code;
 
-	 // prev ctx parents may be a/b/c... and new one is x/y/z...
-	 // find the length of the common parents list
-	 size_t commDepth = 0;
-	 if (prevParentInstNames != nodeCtx->parentInstNames) {
-		pI = nodeCtx->parentInstNames.begin();
-		qI = prevParentInstNames.begin();
-		while ((pI != nodeCtx->parentInstNames.end()) &&
-				 (qI != prevParentInstNames.end()) && 
-				 (*pI == *qI)) {
+	 // prev scope path may be a/b/c... and new one is x/y/z...
+	 // find the length of the common path, close the rest of the prev one
+	 // and open the rest of the new one
+	 if (nodeCtx->scopeId != prevScope) {
+		tree.getPath(nodeCtx->scopeId, path);
+		size_t commDepth = 0;
+		while (commDepth < path.size() && commDepth < prevPath.size() && 
+				 path[commDepth] == prevPath[commDepth]) 
 		  commDepth++;
-		  pI++;
-		  qI++;
-		}
-		
-		// close the hierarchies below prev context
-		// if (qI != prevParentInstNames.end())
-		//  vcd << "$comment E: " << join(prevParentInstNames) << " $end " << endl;
-
-		while (qI != prevParentInstNames.end()) {
-		  //		prefix = prefix.substr(0, prefix.size() - 1);
-		  vcd << prefix << "$upscope $end" << endl;
-		  qI++;
-		}
-		while (pI != nodeCtx->parentInstNames.end()) {
-		  vcd << prefix << "$scope module " << (*pI) << " $end" << endl;
-		  //		prefix = prefix + " ";
-		  pI++;
-		}
-		// vcd << "$comment S: " << join(nodeCtx->parentInstNames) << " $end" << endl;
+		for (size_t i = commDepth; i < prevPath.size(); i++) 
+		  vcd << "$upscope $end" << endl;
+		for (size_t i = commDepth; i < path.size(); i++) 
+		  vcd << "$scope module " << tree.getScopeName(path[i]) << " $end" << endl;
+		prevScope = nodeCtx->scopeId;
+		prevPath.swap(path);
 	 }
 	 // print the node
-    vcd << "$var wire 1 " << code << " " << nodeCtx->nodeName << " $end" << endl;
-	 prevParentInstNames = nodeCtx->parentInstNames;
-  }
-  qI = prevParentInstNames.begin();
-  while (qI != prevParentInstNames.end()) {
-	 // prefix = prefix.substr(0, prefix.size() - 1);
-	 vcd << prefix << "$upscope $end" << endl;
-	 qI++;
+    vcd << "$var wire 1 " << code << " " << nodeCtx->getNode() << " $end" << endl;
   }
-  vcd << prefix << "$upscope $end" << endl;
+  for (size_t i = 0; i < prevPath.size(); i++) 
+	 vcd << "$upscope $end" << endl;
+  vcd << "$upscope $end" << endl;
 
   return(0);
 }
@@ -7,61 +7,84 @@
 #include <set>
 #include <map>
 #include <string>
+#include <vector>
+#include <unordered_map>
 
 using namespace std;
 
 // NOTE: the created VCD only contains top level nodes for nodes 
 // that are external to an instance. 
 
-// An occurrence node is defined by a context:
+// Interned strings - each distinct string gets a small integer symbol
+class vcdSymbolTable {
+  std::vector<std::string> names;
+  std::unordered_map<std::string, int> symbolByName;
+ public:
+  // get the symbol of the string, adding it if new
+  int intern(const std::string &name);
+  const std::string &getName(int symbol) const {return(names[symbol]);};
+};
+
+// The tree of instance scopes. Scope 0 is the top cell, every other scope is 
+// an instance name under its parent scope. Scopes created by a depth first 
+// walk of the hierarchy are numbered in the order the VCD declares them.
+class vcdScopeTree {
+  std::vector<int> parent;
+  std::vector<int> nameSymbol;
+  std::map< std::pair<int,int>, int > childByName;
+  vcdSymbolTable symbols;
+ public:
+  vcdScopeTree();
+
+  // the tree shared by all node contexts
+  static vcdScopeTree &shared();
+
+  // get the scope of the instance under the given scope, adding it if new
+  int getChild(int scope, const std::string &instName);
+
+  // get the scope of a list of parent instance names, adding it if new
+  int getScope(const list<std::string> &parentInstNames);
+
+  int getParent(int scope) const {return(parent[scope]);};
+  int getNumScopes() const {return(parent.size());};
+  const std::string &getScopeName(int scope) const {return(symbols.getName(nameSymbol[scope]));};
+
+  // get the scopes from the top (excluded) down to the given scope
+  void getPath(int scope, std::vector<int> &path) const;
+
+  vcdSymbolTable &getSymbols() {return(symbols);};
+};
+
+// An occurrence node is defined by a context: its scope and name symbol in the
+// shared scope tree
 class vcdNodeCtx {
-  list<std::string> parentInstNames;
-  std::string nodeName;
+  int scopeId;
+  int nameSymbol;
  public:
   vcdNodeCtx(list<std::string> &p, std::string n);
+  vcdNodeCtx(int scope, std::string n);
   std::string getName() const;
-  list<std::string> &getParents() {return(parentInstNames);};
-  std::string getNode() {return(nodeName);};
+  list<std::string> getParents() const;
+  std::string getNode() const {return(vcdScopeTree::shared().getSymbols().getName(nameSymbol));};
+  int getScope() const {return(scopeId);};
+  int getNameSymbol() const {return(nameSymbol);};
   friend class cmpNodeCtx;
   friend class vcdFormatter;
 };
 
+// Orders the contexts by scope then name symbol. Nodes of a scope are adjacent 
+// and scopes keep the order they were created in.
 class cmpNodeCtx {
  public:
   bool operator()(const vcdNodeCtx& a, const vcdNodeCtx& b) const {
-    list<std::string>::const_iterator apI = a.parentInstNames.begin();
-    list<std::string>::const_iterator bpI = b.parentInstNames.begin();
-    while ((apI != a.parentInstNames.end()) && (bpI != b.parentInstNames.end())) {
-      if ((*apI) != (*bpI)) {
-		  return ((*apI) < (*bpI));
-      }
-      apI++; bpI++;
+    if (a.scopeId != b.scopeId) {
+      return (a.scopeId < b.scopeId);
     }
-    if (apI != a.parentInstNames.end()) {
-      return false;
-    } 
-    if (bpI != b.parentInstNames.end()) {
-      return true;
-    }
-    return (a.nodeName < b.nodeName);
+    return (a.nameSymbol < b.nameSymbol);
   };
 
   bool operator()(const vcdNodeCtx *a, const vcdNodeCtx *b) const {
-    list<std::string>::const_iterator apI = a->parentInstNames.begin();
-    list<std::string>::const_iterator bpI = b->parentInstNames.begin();
-    while ((apI != a->parentInstNames.end()) && (bpI != b->parentInstNames.end())) {
-      if ((*apI) != (*bpI)) {
-		  return ((*apI) < (*bpI));
-      }
-      apI++; bpI++;
-    }
-    if (apI != a->parentInstNames.end()) {
-      return false;
-    } 
-    if (bpI != b->parentInstNames.end()) {
-      return true;
-    }
-    return (a->nodeName < b->nodeName);
+    return ((*this)(*a, *b));
   };
 };
 
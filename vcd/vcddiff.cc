@@ -0,0 +1,158 @@
+//
+// Compare two VCD files by the values of their signals bit by bit,
+// reading both files in lockstep so memory does not grow with their length
+// 
+
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include "vcdreader.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////
+// get the names of the bits of a signal, most significant first
+static vector<string> 
+getBitNames(const vcdSignal &sig)
+{
+  vector<string> names;
+  int from, to;
+  if (sig.width > 1 && sscanf(sig.range.c_str(), "[%d:%d]", &from, &to) == 2) {
+    int step = (from > to) ? -1 : 1;
+    for (int i = from; i != to + step; i += step) 
+      names.push_back(sig.name + "[" + to_string(i) + "]");
+  } else if (sig.width > 1) {
+    for (int i = sig.width - 1; i >= 0; i--) 
+      names.push_back(sig.name + "[" + to_string(i) + "]");
+  } else {
+    names.push_back(sig.name + sig.range);
+  }
+  return(names);
+}
+
+int 
+main(int argc, char **argv)
+{
+  int argIdx = 1;
+  unsigned long maxReports = 10;
+  if (argc > 2 && !strcmp(argv[argIdx], "-n")) {
+    maxReports = strtoul(argv[argIdx + 1], NULL, 10);
+    argIdx += 2;
+  }
+  if (argc - argIdx != 2) {
+    cerr << "Usage: " << argv[0] << " [-n max-reports-per-signal] a.vcd b.vcd" << endl;
+    exit(2);
+  }
+
+  vcdReader *readers[2];
+  for (int f = 0; f < 2; f++) {
+    readers[f] = new vcdReader(argv[argIdx + f]);
+    if (!readers[f]->good()) 
+      exit(2);
+  }
+
+  // the bits of both files by name, the bits of every signal and whether each bit is in each file
+  map< string, int > bitByName;
+  vector<string> bitNames;
+  vector< vector<int> > sigBits[2];
+  vector<char> inFile[2];
+  for (int f = 0; f < 2; f++) {
+    for (int s = 0; s < readers[f]->getNumSignals(); s++) {
+      vector<string> names = getBitNames(readers[f]->getSignal(s));
+      vector<int> bits;
+      for (size_t b = 0; b < names.size(); b++) {
+        map< string, int >::iterator bI = bitByName.find(names[b]);
+        if (bI == bitByName.end()) {
+          bI = bitByName.insert(make_pair(names[b], (int)bitNames.size())).first;
+          bitNames.push_back(names[b]);
+          inFile[0].push_back(0);
+          inFile[1].push_back(0);
+        }
+        inFile[f][(*bI).second] = 1;
+        bits.push_back((*bI).second);
+      }
+      sigBits[f].push_back(bits);
+    }
+  }
+  // a bit missing from either file is a difference
+  unsigned long numMissing = 0;
+  for (size_t b = 0; b < bitNames.size(); b++) {
+    for (int f = 0; f < 2; f++) {
+      if (!inFile[f][b]) {
+        cout << "-E- " << bitNames[b] << " is not in " << argv[argIdx + f] << endl;
+        numMissing++;
+      }
+    }
+  }
+
+  vector<char> values[2];
+  values[0].resize(bitNames.size(), 'x');
+  values[1].resize(bitNames.size(), 'x');
+  vector<char> dirty(bitNames.size(), 0);
+  vector<int> dirtyBits;
+  vector<unsigned long> diffs(bitNames.size(), 0);
+  unsigned long numDiffs = 0;
+
+  // the next step of each file
+  unsigned long times[2];
+  vector<vcdChange> changes[2];
+  bool have[2];
+  for (int f = 0; f < 2; f++) 
+    have[f] = !readers[f]->readStep(times[f], changes[f]);
+
+  while (have[0] || have[1]) {
+    unsigned long time;
+    if (have[0] && have[1]) 
+      time = min(times[0], times[1]);
+    else 
+      time = have[0] ? times[0] : times[1];
+
+    // apply the changes of the files that have this time
+    for (int f = 0; f < 2; f++) {
+      if (!have[f] || times[f] != time) 
+        continue;
+      for (size_t c = 0; c < changes[f].size(); c++) {
+        const vector<int> &bits = sigBits[f][changes[f][c].signal];
+        string value = vcdExpandValue(changes[f][c].value, bits.size());
+        for (size_t b = 0; b < bits.size(); b++) {
+          values[f][bits[b]] = value[b];
+          if (!dirty[bits[b]]) {
+            dirty[bits[b]] = 1;
+            dirtyBits.push_back(bits[b]);
+          }
+        }
+      }
+      have[f] = !readers[f]->readStep(times[f], changes[f]);
+    }
+
+    for (size_t d = 0; d < dirtyBits.size(); d++) {
+      int b = dirtyBits[d];
+      dirty[b] = 0;
+      if (!inFile[0][b] || !inFile[1][b] || values[0][b] == values[1][b]) 
+        continue;
+      numDiffs++;
+      if (++diffs[b] <= maxReports) 
+        cout << "-E- " << bitNames[b] << " differs at time " << time << ": " 
+             << values[0][b] << " vs " << values[1][b] << endl;
+    }
+    dirtyBits.clear();
+  }
+
+  int numSignals = 0;
+  for (size_t b = 0; b < bitNames.size(); b++) {
+    if (diffs[b] > maxReports) 
+      cout << "-I- " << bitNames[b] << ": " << diffs[b] - maxReports << " more differences" << endl;
+    if (diffs[b]) 
+      numSignals++;
+  }
+  delete readers[0];
+  delete readers[1];
+  if (numMissing) 
+    cout << "-I- " << numMissing << " bits are in one file only" << endl;
+  if (numDiffs) 
+    cout << "-I- " << numDiffs << " differences in " << numSignals << " signals" << endl;
+  if (numDiffs || numMissing) 
+    return(1);
+  cout << "-I- No differences" << endl;
+  return(0);
+}
@@ -0,0 +1,289 @@
+//
+// A streaming reader of VCD files
+// 
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <iostream>
+#include "vcdreader.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////
+string 
+vcdExpandValue(const string &value, int width)
+{
+  string v = value;
+  if (v.size() && (v[0] == 'b' || v[0] == 'B')) 
+    v = v.substr(1);
+  for (size_t i = 0; i < v.size(); i++) 
+    v[i] = tolower(v[i]);
+  if (v.empty()) 
+    v = "x";
+  if ((int)v.size() >= width) 
+    return(v.substr(v.size() - width));
+  // a leading 1 is extended with 0, x and z extend themselves
+  char pad = (v[0] == '1') ? '0' : v[0];
+  return(string(width - v.size(), pad) + v);
+}
+
+///////////////////////////////////////////////////////////////////////////
+vcdReader::vcdReader(string fileName)
+{
+  is_good = false;
+  bufPos = bufLen = 0;
+  bufOffset = tokOffset = 0;
+  curTime = nextTime = 0;
+  haveNextTime = atEnd = false;
+  dataOffset = stepOffset = nextOffset = 0;
+  buf.resize(VCD_READ_BUF_SIZE);
+  fp = fopen(fileName.c_str(), "rb");
+  if (!fp) {
+    cerr << "-E- Could not open VCD file: " << fileName << endl;
+    return;
+  }
+  if (readHeader()) {
+    cerr << "-E- Could not parse the header of VCD file: " << fileName << endl;
+    return;
+  }
+  is_good = true;
+}
+
+vcdReader::~vcdReader()
+{
+  if (fp) 
+    fclose(fp);
+}
+
+bool 
+vcdReader::nextToken(string &tok)
+{
+  tok.clear();
+  while (1) {
+    if (bufPos == bufLen) {
+      bufOffset += bufLen;
+      bufLen = fread(&buf[0], 1, buf.size(), fp);
+      bufPos = 0;
+      if (!bufLen) 
+        return(!tok.empty());
+    }
+    char c = buf[bufPos];
+    if (isspace((unsigned char)c)) {
+      bufPos++;
+      if (!tok.empty()) 
+        return(true);
+      continue;
+    }
+    if (tok.empty()) 
+      tokOffset = bufOffset + bufPos;
+    tok += c;
+    bufPos++;
+  }
+}
+
+bool 
+vcdReader::skipToEnd()
+{
+  string tok;
+  while (nextToken(tok)) {
+    if (tok == "$end") 
+      return(true);
+  }
+  return(false);
+}
+
+void 
+vcdReader::seek(long offset)
+{
+  fseek(fp, offset, SEEK_SET);
+  bufOffset = offset;
+  bufPos = bufLen = 0;
+  haveNextTime = atEnd = false;
+}
+
+int 
+vcdReader::readHeader()
+{
+  string tok;
+  vector<string> scopes;
+  while (nextToken(tok)) {
+    if (tok == "$scope") {
+      string type, name;
+      if (!nextToken(type) || !nextToken(name) || !skipToEnd()) 
+        return(1);
+      scopes.push_back(name);
+    } else if (tok == "$upscope") {
+      if (scopes.empty() || !skipToEnd()) 
+        return(1);
+      scopes.pop_back();
+    } else if (tok == "$var") {
+      string type, width;
+      vcdSignal sig;
+      if (!nextToken(type) || !nextToken(width) || !nextToken(sig.code) || !nextToken(sig.name)) 
+        return(1);
+      sig.width = atoi(width.c_str());
+      while (nextToken(tok) && tok != "$end") 
+        sig.range += tok;
+      for (int i = scopes.size() - 1; i >= 0; i--) 
+        sig.name = scopes[i] + "." + sig.name;
+      signalsByCode[sig.code].push_back(signals.size());
+      signalByName[sig.name] = signals.size();
+      signals.push_back(sig);
+    } else if (tok == "$enddefinitions") {
+      if (!skipToEnd()) 
+        return(1);
+      dataOffset = stepOffset = bufOffset + bufPos;
+      numChanges.resize(signals.size(), 0);
+      index.resize(signals.size());
+      return(0);
+    } else if (tok[0] == '$') {
+      if (!skipToEnd()) 
+        return(1);
+    } else {
+      return(1);
+    }
+  }
+  return(1);
+}
+
+int 
+vcdReader::findSignal(string name) const
+{
+  map< string, int >::const_iterator sI = signalByName.find(name);
+  if (sI == signalByName.end()) 
+    return(-1);
+  return((*sI).second);
+}
+
+void 
+vcdReader::rewind()
+{
+  seek(dataOffset);
+  curTime = 0;
+  stepOffset = dataOffset;
+}
+
+int 
+vcdReader::readStep(unsigned long &time, vector<vcdChange> &changes)
+{
+  changes.clear();
+  if (atEnd) 
+    return(1);
+  if (haveNextTime) {
+    curTime = nextTime;
+    stepOffset = nextOffset;
+    haveNextTime = false;
+  }
+
+  // empty sections are merged into the next one
+  bool any = false;
+  string tok;
+  while (nextToken(tok)) {
+    if (tok[0] == '#') {
+      unsigned long t = strtoul(tok.c_str() + 1, NULL, 10);
+      if (!any) {
+        curTime = t;
+        stepOffset = bufOffset + bufPos;
+        continue;
+      }
+      nextTime = t;
+      nextOffset = bufOffset + bufPos;
+      haveNextTime = true;
+      time = curTime;
+      return(0);
+    }
+    if (tok[0] == '$') {
+      if (tok == "$comment") 
+        skipToEnd();
+      continue;
+    }
+
+    vcdChange change;
+    string code;
+    if (tok[0] == 'b' || tok[0] == 'B' || tok[0] == 'r' || tok[0] == 'R') {
+      change.value = tok;
+      if (!nextToken(code)) 
+        break;
+    } else {
+      change.value = tok.substr(0, 1);
+      code = tok.substr(1);
+    }
+    map< string, vector<int> >::const_iterator cI = signalsByCode.find(code);
+    if (cI == signalsByCode.end()) {
+      cerr << "-W- Unknown VCD code: " << code << " at time " << curTime << endl;
+      continue;
+    }
+    for (size_t s = 0; s < (*cI).second.size(); s++) {
+      change.signal = (*cI).second[s];
+      changes.push_back(change);
+    }
+    any = true;
+  }
+  atEnd = true;
+  time = curTime;
+  return(any ? 0 : 1);
+}
+
+int 
+vcdReader::buildIndex()
+{
+  vector<string> values(signals.size(), "x");
+  for (size_t s = 0; s < signals.size(); s++) {
+    index[s].clear();
+    numChanges[s] = 0;
+  }
+
+  rewind();
+  unsigned long time;
+  vector<vcdChange> changes;
+  while (!readStep(time, changes)) {
+    long offset = stepOffset;
+    for (size_t c = 0; c < changes.size(); c++) {
+      int s = changes[c].signal;
+      // index the section of every VCD_INDEX_STRIDE'th change, with the value before it
+      if (numChanges[s] % VCD_INDEX_STRIDE == 0 && 
+          (index[s].empty() || index[s].back().offset != offset)) {
+        vcdIndexEntry entry = { time, offset, values[s] };
+        index[s].push_back(entry);
+      }
+      numChanges[s]++;
+      values[s] = changes[c].value;
+    }
+  }
+  rewind();
+  return(0);
+}
+
+int 
+vcdReader::getValue(int signal, unsigned long time, string &value)
+{
+  // the last indexed section at or before the time
+  const vector<vcdIndexEntry> &entries = index[signal];
+  int lo = 0, hi = entries.size() - 1, found = -1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (entries[mid].time <= time) {
+      found = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  value = "x";
+  if (found < 0) 
+    return(0);
+
+  seek(entries[found].offset);
+  curTime = entries[found].time;
+  value = entries[found].value;
+  unsigned long t;
+  vector<vcdChange> changes;
+  while (!readStep(t, changes) && t <= time) {
+    for (size_t c = 0; c < changes.size(); c++) {
+      if (changes[c].signal == signal) 
+        value = changes[c].value;
+    }
+  }
+  return(0);
+}
@@ -0,0 +1,122 @@
+//
+// A streaming reader of VCD files
+// 
+
+#ifndef VCDREADER_H
+#define VCDREADER_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+// size of the read buffer, the only part of the file held in memory
+#define VCD_READ_BUF_SIZE (1 << 20)
+// the change index keeps one entry every this many changes of a signal
+#define VCD_INDEX_STRIDE 64
+
+// A variable declared in the header, its name includes the scopes (i.e DUT.a.b)
+struct vcdSignal {
+  std::string name;
+  std::string code;
+  int width;
+  // the range as declared (i.e [7:0]), empty if none
+  std::string range;
+};
+
+// A value change, the value is as written in the file (i.e 1, x, b1010)
+struct vcdChange {
+  int signal;
+  std::string value;
+};
+
+// An entry of the change index - the value of a signal when a time section holding one of
+// its changes starts and where the changes of that section are in the file
+struct vcdIndexEntry {
+  unsigned long time;
+  long offset;
+  std::string value;
+};
+
+class vcdReader {
+  FILE *fp;
+  bool is_good;
+  std::vector<vcdSignal> signals;
+  // the signals sharing each code
+  std::map< std::string, std::vector<int> > signalsByCode;
+  std::map< std::string, int > signalByName;
+
+  // the read buffer and the file offset of its first byte
+  std::vector<char> buf;
+  size_t bufPos;
+  size_t bufLen;
+  long bufOffset;
+  // the offset of the last token read
+  long tokOffset;
+
+  // the time of the changes being read and the time of the next section if already seen
+  unsigned long curTime;
+  bool haveNextTime;
+  unsigned long nextTime;
+  bool atEnd;
+  // the offset of the first change after the header and of the first change of the last step read
+  long dataOffset;
+  long stepOffset;
+  long nextOffset;
+
+  // the change index, per signal
+  std::vector< std::vector<vcdIndexEntry> > index;
+  std::vector<unsigned long> numChanges;
+
+  // read the next white space separated token, return false at end of file
+  bool nextToken(std::string &tok);
+
+  // skip tokens up to and including $end
+  bool skipToEnd();
+
+  // parse the header up to $enddefinitions
+  int readHeader();
+
+  // move the read position to the given offset
+  void seek(long offset);
+
+ public:
+  // open the file and read its header
+  vcdReader(std::string fileName);
+
+  ~vcdReader();
+
+  bool good() {return(is_good);};
+
+  int getNumSignals() const {return(signals.size());};
+  const vcdSignal &getSignal(int signal) const {return(signals[signal]);};
+
+  // get the signal of the given name, -1 if none
+  int findSignal(std::string name) const;
+
+  // read all the changes of the next time section
+  // return 0 if successful, 1 at the end of the file
+  int readStep(unsigned long &time, std::vector<vcdChange> &changes);
+
+  // restart reading the changes from the start of the file
+  void rewind();
+
+  // read the whole file once and build the per signal change index
+  // return 0 if successful
+  int buildIndex();
+
+  // number of changes of the signal, valid after buildIndex
+  unsigned long getNumChanges(int signal) const {return(numChanges[signal]);};
+
+  // get the value of the signal at the given time using the index, x if not set yet
+  // return 0 if successful
+  int getValue(int signal, unsigned long time, std::string &value);
+};
+
+// expand a value to the given number of bits, most significant first, following the VCD
+// rules for left extension
+std::string vcdExpandValue(const std::string &value, int width);
+
+#endif // VCDREADER_H